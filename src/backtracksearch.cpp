@@ -9,8 +9,20 @@ void BacktrackSearch::StepSolution(const Board &puzzle)
 	// deal with timeout
 	if (timedOut)
 		return;
+	if (StopRequested())
+	{
+		timedOut = true;
+		return;
+	}
 	stepCount++;
-	if ( stepCount%5000 == 0 )
+	if ( nodeLimit > 0 && stepCount > nodeLimit )
+	{
+		timedOut = true;
+		return;
+	}
+	// a step copies and propagates the whole board, which on 64x64 takes
+	// long enough that checking less often overruns the deadline
+	if ( stepCount%16 == 0 )
 	{
 		if ( solutionTimer.Elapsed() > timeOut )
 		{
@@ -39,35 +51,55 @@ void BacktrackSearch::StepSolution(const Board &puzzle)
 		return;
 	}
 
-	// try the possibilities in turn
-	ValueSet choice = ValueSet(puzzle.GetNumUnits(), 1);
+	// try the possibilities in turn, best weighted first if there are weights
+	int order[64];
+	int numChoices = 0;
 	for (int i = 0; i < puzzle.GetNumUnits(); i++)
 	{
-		if (solved)
-			return;
-		if ( puzzle.GetCell(nextCell).Contains(choice))
+		if (puzzle.GetCell(nextCell).Contains(ValueSet(puzzle.GetNumUnits(), (uint64_t)1 << i)))
 		{
-			// copy the board
-			Board newBoard;
-			newBoard.Copy(puzzle);
-			// set the cell
-			newBoard.SetCell(nextCell, choice);
-			// did we solve the puzzle?
-			if (newBoard.FixedCellCount() == newBoard.CellCount())
+			int j = numChoices++;
+			if (valueWeights != nullptr)
 			{
-				// solved
-				solved = true;
-				solution.Copy(newBoard);
-				return;
+				// insertion sort on decreasing weight
+				for (; j > 0 && valueWeights[nextCell][order[j-1]] < valueWeights[nextCell][i]; j--)
+					order[j] = order[j-1];
 			}
-			// check no conflicts
-			if (newBoard.InfeasibleCellCount() == 0)
+			order[j] = i;
+		}
+	}
+	for (int k = 0; k < numChoices; k++)
+	{
+		if (solved || timedOut)
+			return;
+		ValueSet choice = ValueSet(puzzle.GetNumUnits(), (uint64_t)1 << order[k]);
+		// copy the board
+		Board newBoard;
+		newBoard.Copy(puzzle);
+		// set the cell
+		newBoard.SetCell(nextCell, choice);
+		// did we solve the puzzle?
+		if (newBoard.FixedCellCount() == newBoard.CellCount())
+		{
+			// solved
+			solved = true;
+			solution.Copy(newBoard);
+			RecordImprovement(solutionTimer.Elapsed(), newBoard.CellCount(), 0);
+			return;
+		}
+		// check no conflicts
+		if (newBoard.InfeasibleCellCount() == 0)
+		{
+			// keep the fullest board so far, as the answer if time runs out
+			if (newBoard.FixedCellCount() > bestFilled)
 			{
-				// carry on and set the next cell
-				StepSolution(newBoard);
+				bestFilled = newBoard.FixedCellCount();
+				solution.Copy(newBoard);
+				RecordImprovement(solutionTimer.Elapsed(), bestFilled, 0);
 			}
+			// carry on and set the next cell
+			StepSolution(newBoard);
 		}
-		choice <<= 1;
 	}
 }
 
@@ -75,9 +107,51 @@ bool BacktrackSearch::Solve(const Board& puzzle, float maxTime)
 {
 	solved = false;
 	timedOut = false;
+	stepCount = 0;
 	timeOut = maxTime;
 	solutionTimer.Reset();
-	StepSolution(puzzle);
+	trace.clear();
+	solution.Copy(puzzle);
+	bestFilled = puzzle.InfeasibleCellCount() == 0 ? puzzle.FixedCellCount() : 0;
+	if (!warmRows.empty() && (int)warmRows.size() == puzzle.CellCount())
+	{
+		// follow the warm start for a few steps per cell, and search from
+		// scratch if that does not find a solution, as a bad early choice
+		// can cost far more than a cold search
+		float **weights = valueWeights;
+		int limit = nodeLimit;
+		valueWeights = warmRows.data();
+		nodeLimit = puzzle.CellCount() * 4;
+		if (limit > 0 && limit < nodeLimit)
+			nodeLimit = limit;
+		StepSolution(puzzle);
+		valueWeights = weights;
+		nodeLimit = limit;
+		if (!solved && !StopRequested() && solutionTimer.Elapsed() < timeOut)
+		{
+			timedOut = false;
+			stepCount = 0;
+			StepSolution(puzzle);
+		}
+	}
+	else
+		StepSolution(puzzle);
+	warmRows.clear();
 	solTime = solutionTimer.Elapsed();
 	return solved;
 }
+
+void BacktrackSearch::SetWarmStart(const Board &previous)
+{
+	// try each cell's previous value first
+	int numCells = previous.CellCount();
+	int numUnits = previous.GetNumUnits();
+	warmWeights.assign(numCells * numUnits, 0.0f);
+	warmRows.resize(numCells);
+	for (int i = 0; i < numCells; i++)
+	{
+		warmRows[i] = &warmWeights[i * numUnits];
+		if (previous.GetCell(i).Fixed())
+			warmRows[i][previous.GetCell(i).Index()] = 1.0f;
+	}
+}
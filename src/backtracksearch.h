@@ -2,6 +2,7 @@
 #include "board.h"
 #include "timer.h"
 #include "sudokusolver.h"
+#include <vector>
 
 class BacktrackSearch : public SudokuSolver
 {
@@ -14,11 +15,19 @@ private:
 	int stepCount;
 	bool timedOut;
 	float timeOut;
+	int nodeLimit;	// give up after this many steps, 0 for no limit
+	int bestFilled;	// fixed cells in the fullest board reached
+	float **valueWeights;	// if set, try values in order of decreasing weight
+	std::vector<float> warmWeights;	// for the next solve only, the warm start's values first
+	std::vector<float *> warmRows;
 public:
-BacktrackSearch() : solTime(0.0f), stepCount(0), timedOut(false) {}
+BacktrackSearch() : solTime(0.0f), stepCount(0), timedOut(false), nodeLimit(0), bestFilled(0), valueWeights(nullptr) {}
 	virtual bool Solve(const Board& puzzle, float maxTime);
 	virtual float GetSolutionTime() { return solTime; }
 	virtual int GetCycles() { return 0; }
 	virtual const Board& GetSolution() { return solution; }
 	int GetStepCount() { return stepCount; }
+	void SetNodeLimit(int n) { nodeLimit = n; }
+	void SetValueWeights(float **w) { valueWeights = w; }
+	virtual void SetWarmStart(const Board &previous);
 };
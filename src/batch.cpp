@@ -0,0 +1,98 @@
+#include "batch.h"
+#include "board.h"
+#include "sudokulib.h"
+#include "packedarchive.h"
+#include "random.h"
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <sstream>
+using namespace std;
+
+PuzzleSource *OpenPuzzleSource( Arguments &a, int numThreads )
+{
+	string batchSource = a.GetArg(string("batch"),string());
+	string bulkFile = a.GetArg(string("bulk"),string());
+	string archiveFile = a.GetArg(string("archive"),string());
+	if ( archiveFile.length() != 0 )
+	{
+		int clues = a.GetArg("clues", -1);
+		int minClues = a.GetArg("minclues", clues < 0 ? 0 : clues);
+		int maxClues = a.GetArg("maxclues", clues < 0 ? 100 : clues);
+		return new PackedArchive(archiveFile, a.GetArg("size", 0), minClues, maxClues);
+	}
+	if ( bulkFile.length() != 0 )
+		return new BulkPuzzleFile(bulkFile, numThreads);
+	if ( batchSource.length() != 0 )
+		return new InstanceFiles(ListInstances(batchSource));
+	return nullptr;
+}
+
+int RunBatch( const PuzzleSource &puzzles, const SolverOptions &opt, int runs, int numThreads, ostream &out )
+{
+	if ( numThreads < 1 )
+		numThreads = 1;
+	long long numItems = (long long)puzzles.Count() * runs;
+	atomic<long long> nextItem(0);
+	atomic<int> numFailed(0);
+	mutex outMutex;
+	// shared by all workers, so a repeat is found whichever worker solved it first
+	SolutionCache *cache = CreateSolutionCache(opt);
+
+	out << "instance,run,success,time,cycles" << endl;
+	auto worker = [&]()
+	{
+		// one solver context per board size, kept for all this worker's runs
+		vector<SudokuContext *> contexts(65, nullptr);
+		for ( long long item = nextItem++; item < numItems; item = nextItem++ )
+		{
+			int inst = (int)(item / runs);
+			int run = (int)(item % runs);
+			bool success = false;
+			float solTime = 0.0f;
+			int cycles = 0;
+			int length;
+			const char *text = puzzles.Text(inst, length);
+			if ( length != 0 )
+			{
+				// parsed straight from the source's memory, in the worker
+				Board board(text, length);
+				int numUnits = board.GetNumUnits();
+				if ( numUnits != 0 )
+				{
+					if ( contexts[numUnits] == nullptr )
+					{
+						contexts[numUnits] = new SudokuContext(numUnits, opt);
+						contexts[numUnits]->SetCache(cache);
+					}
+					// seeded by item, so a run does not depend on which worker took it
+					if ( opt.seed != 0 )
+						contexts[numUnits]->SetSeed(DeriveSeed(opt.seed, (uint32_t)item));
+					success = contexts[numUnits]->Solve(board);
+					solTime = contexts[numUnits]->GetSolutionTime();
+					cycles = contexts[numUnits]->GetCycles();
+				}
+			}
+			if ( !success )
+				++numFailed;
+
+			ostringstream record;
+			puzzles.Name(inst, record);
+			record << ',' << run << ',' << (success ? 1 : 0) << ',' << solTime << ',' << cycles << '\n';
+			lock_guard<mutex> lock(outMutex);
+			out << record.str();
+		}
+		for ( auto c : contexts )
+			delete c;
+	};
+
+	vector<thread> threads;
+	for ( int t = 1; t < numThreads; t++ )
+		threads.push_back(thread(worker));
+	worker();
+	for ( auto &t : threads )
+		t.join();
+	delete cache;
+	out.flush();
+	return numFailed;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "solveroptions.h"
+#include "puzzleio.h"
+#include "arguments.h"
+#include <string>
+#include <vector>
+#include <ostream>
+
+// the puzzles named by --batch, --bulk or --archive (with its --size and
+// --clues filters), owned by the caller; nullptr if none of those is given
+PuzzleSource *OpenPuzzleSource( Arguments &a, int numThreads );
+
+// Solve every puzzle runs times on a pool of numThreads workers, each with
+// its own solver contexts, and write one record per run to out as runs finish:
+//   instance,run,success,time,cycles
+// with success 1 for a valid solution. Returns the number of failed runs.
+int RunBatch( const PuzzleSource &puzzles, const SolverOptions &opt, int runs, int numThreads, std::ostream &out );
@@ -0,0 +1,66 @@
+#include "benchmark.h"
+#include "batch.h"
+#include "solveroptions.h"
+#include "arguments.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+int main( int argc, char *argv[] )
+{
+	// sudokubench: solve puzzles in this process and summarise the runs per
+	// board size and clue percentage, or compare such a summary with a baseline
+	Arguments a( argc, argv );
+
+	string compareFile = a.GetArg(string("compare"),string());
+	string withFile = a.GetArg(string("with"),string());
+	string outFile = a.GetArg(string("out"),string());
+
+	vector<BenchGroup> results;
+	if ( withFile.length() != 0 )
+	{
+		// compare two stored summaries, without solving anything
+		if ( !ReadBenchCsv(withFile, results) )
+		{
+			cerr << "cannot read results from " << withFile << endl;
+			return 1;
+		}
+	}
+	else
+	{
+		PuzzleSource *puzzles = OpenPuzzleSource(a, 1);
+		if ( puzzles == nullptr )
+		{
+			cerr << "no puzzles: give --batch, --bulk or --archive" << endl;
+			return 1;
+		}
+		int runs = a.GetArg("runs", 1);
+		int warmup = a.GetArg("warmup", 1);
+		unsigned int seed = (unsigned int)a.GetArg("seed", 1);
+		results = RunBenchmark(*puzzles, ReadSolverOptions(a), runs, warmup, seed, &cerr);
+		delete puzzles;
+
+		if ( outFile.length() != 0 )
+		{
+			ofstream out(outFile.c_str());
+			WriteBenchCsv(results, out);
+		}
+		else if ( compareFile.length() == 0 )
+			WriteBenchCsv(results, cout);
+	}
+
+	if ( compareFile.length() != 0 )
+	{
+		vector<BenchGroup> baseline;
+		if ( !ReadBenchCsv(compareFile, baseline) )
+		{
+			cerr << "cannot read results from " << compareFile << endl;
+			return 1;
+		}
+		// fail if anything got significantly worse
+		return CompareBench(baseline, results, a.GetArg("alpha", 0.05), cout) != 0;
+	}
+	return 0;
+}
@@ -0,0 +1,320 @@
+#include "benchmark.h"
+#include "sudokulib.h"
+#include "board.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <map>
+#include <cmath>
+#include <cstdlib>
+using namespace std;
+
+namespace
+{
+	// value below which fraction of the sorted values lie, interpolating
+	// between neighbours
+	double Percentile( const vector<double> &sorted, double fraction )
+	{
+		if ( sorted.empty() )
+			return 0.0;
+		double pos = fraction * (sorted.size() - 1);
+		size_t below = (size_t)pos;
+		if ( below + 1 >= sorted.size() )
+			return sorted.back();
+		return sorted[below] + (pos - below) * (sorted[below + 1] - sorted[below]);
+	}
+
+	void Summarise( BenchGroup &g )
+	{
+		int n = (int)g.times.size();
+		g.meanTime = 0.0;
+		for ( double t : g.times )
+			g.meanTime += t;
+		g.meanTime = n > 0 ? g.meanTime / n : 0.0;
+		double sumSq = 0.0;
+		for ( double t : g.times )
+			sumSq += (t - g.meanTime) * (t - g.meanTime);
+		g.stdTime = n > 1 ? sqrt(sumSq / (n - 1)) : 0.0;
+		g.cycles = n > 0 ? g.cycles / n : 0.0;
+		vector<double> sorted(g.times);
+		sort(sorted.begin(), sorted.end());
+		g.medianTime = Percentile(sorted, 0.5);
+		g.p90Time = Percentile(sorted, 0.9);
+		g.p99Time = Percentile(sorted, 0.99);
+	}
+
+	string TypeName( int numUnits )
+	{
+		ostringstream s;
+		s << numUnits << 'x' << numUnits;
+		return s.str();
+	}
+
+	vector<string> SplitCsv( const string &line )
+	{
+		vector<string> fields;
+		istringstream in(line);
+		string field;
+		while ( getline(in, field, ',') )
+		{
+			if ( !field.empty() && field.back() == '\r' )
+				field.pop_back();
+			fields.push_back(field);
+		}
+		return fields;
+	}
+
+	// continued fraction for the incomplete beta function, by the modified
+	// Lentz method
+	double BetaFraction( double a, double b, double x )
+	{
+		const double tiny = 1e-300;
+		double c = 1.0;
+		double d = 1.0 - (a + b) * x / (a + 1.0);
+		if ( fabs(d) < tiny )
+			d = tiny;
+		d = 1.0 / d;
+		double h = d;
+		for ( int m = 1; m <= 300; m++ )
+		{
+			double m2 = 2.0 * m;
+			double aa = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+			d = 1.0 + aa * d;
+			d = fabs(d) < tiny ? 1.0 / tiny : 1.0 / d;
+			c = 1.0 + aa / c;
+			if ( fabs(c) < tiny )
+				c = tiny;
+			h *= d * c;
+			aa = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+			d = 1.0 + aa * d;
+			d = fabs(d) < tiny ? 1.0 / tiny : 1.0 / d;
+			c = 1.0 + aa / c;
+			if ( fabs(c) < tiny )
+				c = tiny;
+			double step = d * c;
+			h *= step;
+			if ( fabs(step - 1.0) < 1e-12 )
+				break;
+		}
+		return h;
+	}
+
+	// regularised incomplete beta function I_x(a, b)
+	double IncompleteBeta( double a, double b, double x )
+	{
+		if ( x <= 0.0 )
+			return 0.0;
+		if ( x >= 1.0 )
+			return 1.0;
+		double front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log(1.0 - x));
+		if ( x < (a + 1.0) / (a + b + 2.0) )
+			return front * BetaFraction(a, b, x) / a;
+		return 1.0 - front * BetaFraction(b, a, 1.0 - x) / b;
+	}
+
+	// two-sided p-value of a difference in success rates
+	double ProportionTest( int s1, int n1, int s2, int n2 )
+	{
+		if ( n1 == 0 || n2 == 0 )
+			return 1.0;
+		double pooled = (double)(s1 + s2) / (n1 + n2);
+		double se = sqrt(pooled * (1.0 - pooled) * (1.0 / n1 + 1.0 / n2));
+		if ( se == 0.0 )
+			return 1.0;
+		double z = ((double)s2 / n2 - (double)s1 / n1) / se;
+		return erfc(fabs(z) / sqrt(2.0));
+	}
+}
+
+double WelchTest( double mean1, double sd1, int n1, double mean2, double sd2, int n2, double &t, double &df )
+{
+	t = 0.0;
+	df = 0.0;
+	if ( n1 < 2 || n2 < 2 )
+		return 1.0;
+	double v1 = sd1 * sd1 / n1;
+	double v2 = sd2 * sd2 / n2;
+	if ( v1 + v2 == 0.0 )
+		return mean1 == mean2 ? 1.0 : 0.0;
+	t = (mean2 - mean1) / sqrt(v1 + v2);
+	df = (v1 + v2) * (v1 + v2) / (v1 * v1 / (n1 - 1) + v2 * v2 / (n2 - 1));
+	return IncompleteBeta(df / 2.0, 0.5, df / (df + t * t));
+}
+
+vector<BenchGroup> RunBenchmark( const PuzzleSource &puzzles, const SolverOptions &opt, int runs, int warmup, unsigned int seed, ostream *progress )
+{
+	map<pair<int, int>, BenchGroup> groups;
+	vector<SudokuContext *> contexts(65, nullptr);
+	BenchGroup *last = nullptr;
+	for ( int i = 0; i < puzzles.Count(); i++ )
+	{
+		int length;
+		const char *text = puzzles.Text(i, length);
+		Board board(text, length);
+		int numUnits = length != 0 ? board.GetNumUnits() : 0;
+		if ( numUnits == 0 )
+		{
+			if ( progress != nullptr )
+			{
+				*progress << "skipping ";
+				puzzles.Name(i, *progress);
+				*progress << endl;
+			}
+			continue;
+		}
+		int numClues = 0;
+		for ( int c = 0; c < board.CellCount(); c++ )
+			if ( board.IsClue(c) )
+				++numClues;
+		ostringstream name;
+		puzzles.Name(i, name);
+		int pct = NominalCluePercent(name.str(), numClues, board.CellCount());
+
+		BenchGroup &g = groups[make_pair(numUnits, pct)];
+		if ( g.numUnits == 0 )
+		{
+			g = BenchGroup();
+			g.numUnits = numUnits;
+			g.cluePercent = pct;
+		}
+		if ( progress != nullptr && last != nullptr && last != &g )
+			*progress << TypeName(last->numUnits) << ' ' << last->cluePercent << "%: " << last->successes << " of " << last->total << " solved" << endl;
+		last = &g;
+
+		SudokuContext *&ctx = contexts[numUnits];
+		if ( ctx == nullptr )
+		{
+			ctx = new SudokuContext(numUnits, opt);
+			for ( int w = 0; w < warmup; w++ )
+			{
+				ctx->SetSeed(seed - 1 - (unsigned int)w);
+				ctx->Solve(board);
+			}
+		}
+		for ( int r = 0; r < runs; r++ )
+		{
+			ctx->SetSeed(seed + (unsigned int)(i * runs + r));
+			g.total++;
+			if ( ctx->Solve(board) )
+			{
+				g.successes++;
+				g.times.push_back(ctx->GetSolutionTime());
+				g.cycles += ctx->GetCycles();
+			}
+		}
+	}
+	if ( progress != nullptr && last != nullptr )
+		*progress << TypeName(last->numUnits) << ' ' << last->cluePercent << "%: " << last->successes << " of " << last->total << " solved" << endl;
+	for ( auto c : contexts )
+		delete c;
+
+	vector<BenchGroup> results;
+	for ( auto &entry : groups )
+	{
+		Summarise(entry.second);
+		results.push_back(entry.second);
+	}
+	return results;
+}
+
+void WriteBenchCsv( const vector<BenchGroup> &groups, ostream &out )
+{
+	out << "Type,Clue %,Total Instances,Successes,Success Rate (%),Avg Time,Std Dev Time,Cycles,Median Time,P90 Time,P99 Time" << endl;
+	out << fixed;
+	for ( const BenchGroup &g : groups )
+	{
+		double rate = g.total > 0 ? 100.0 * g.successes / g.total : 0.0;
+		out << TypeName(g.numUnits) << ',' << g.cluePercent << ',' << g.total << ',' << g.successes << ',';
+		out << setprecision(2) << rate << ',';
+		out << setprecision(8) << g.meanTime << ',' << g.stdTime << ',';
+		out << setprecision(2) << g.cycles << ',';
+		out << setprecision(8) << g.medianTime << ',' << g.p90Time << ',' << g.p99Time << endl;
+	}
+}
+
+bool ReadBenchCsv( const string &fileName, vector<BenchGroup> &groups )
+{
+	ifstream in(fileName.c_str());
+	string line;
+	if ( !getline(in, line) )
+		return false;
+	vector<string> header = SplitCsv(line);
+	map<string, size_t> column;
+	for ( size_t k = 0; k < header.size(); k++ )
+		column[header[k]] = k;
+	const char *required[] = { "Type", "Clue %", "Total Instances", "Successes", "Avg Time", "Std Dev Time" };
+	for ( const char *name : required )
+		if ( column.find(name) == column.end() )
+			return false;
+
+	groups.clear();
+	while ( getline(in, line) )
+	{
+		vector<string> f = SplitCsv(line);
+		if ( f.size() < header.size() )
+			continue;
+		auto value = [&]( const char *name ) { auto c = column.find(name); return c == column.end() ? 0.0 : atof(f[c->second].c_str()); };
+		BenchGroup g = BenchGroup();
+		g.numUnits = atoi(f[column["Type"]].c_str());
+		g.cluePercent = (int)value("Clue %");
+		g.total = (int)value("Total Instances");
+		g.successes = (int)value("Successes");
+		g.meanTime = value("Avg Time");
+		g.stdTime = value("Std Dev Time");
+		g.cycles = value("Cycles");
+		g.medianTime = value("Median Time");
+		g.p90Time = value("P90 Time");
+		g.p99Time = value("P99 Time");
+		groups.push_back(g);
+	}
+	return true;
+}
+
+int CompareBench( const vector<BenchGroup> &baseline, const vector<BenchGroup> &current, double alpha, ostream &out )
+{
+	map<pair<int, int>, const BenchGroup *> base;
+	for ( const BenchGroup &g : baseline )
+		base[make_pair(g.numUnits, g.cluePercent)] = &g;
+
+	int numWorse = 0;
+	out << "Type,Clue %,Base Rate (%),Rate (%),Rate p,Base Time,Time,Change (%),t,df,Time p,Result" << endl;
+	out << fixed;
+	for ( const BenchGroup &g : current )
+	{
+		auto found = base.find(make_pair(g.numUnits, g.cluePercent));
+		if ( found == base.end() )
+			continue;
+		const BenchGroup &b = *found->second;
+		double baseRate = b.total > 0 ? 100.0 * b.successes / b.total : 0.0;
+		double rate = g.total > 0 ? 100.0 * g.successes / g.total : 0.0;
+		double rateP = ProportionTest(b.successes, b.total, g.successes, g.total);
+		double t, df;
+		double timeP = WelchTest(b.meanTime, b.stdTime, b.successes, g.meanTime, g.stdTime, g.successes, t, df);
+		double change = b.meanTime > 0.0 ? 100.0 * (g.meanTime - b.meanTime) / b.meanTime : 0.0;
+
+		string result;
+		bool worse = false;
+		if ( rateP < alpha )
+		{
+			result = rate < baseRate ? "fewer solved" : "more solved";
+			worse = rate < baseRate;
+		}
+		if ( timeP < alpha )
+		{
+			result += result.empty() ? "" : " ";
+			result += g.meanTime > b.meanTime ? "slower" : "faster";
+			worse = worse || g.meanTime > b.meanTime;
+		}
+		if ( result.empty() )
+			result = "no significant change";
+		if ( worse )
+			++numWorse;
+
+		out << TypeName(g.numUnits) << ',' << g.cluePercent << ',';
+		out << setprecision(2) << baseRate << ',' << rate << ',' << setprecision(4) << rateP << ',';
+		out << setprecision(8) << b.meanTime << ',' << g.meanTime << ',';
+		out << setprecision(2) << change << ',' << t << ',' << df << ',' << setprecision(4) << timeP << ',' << result << endl;
+	}
+	return numWorse;
+}
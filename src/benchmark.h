@@ -0,0 +1,56 @@
+#pragma once
+#include "solveroptions.h"
+#include "puzzleio.h"
+#include <string>
+#include <vector>
+#include <ostream>
+
+//
+// In-process benchmarking, for sudokubench. Results are kept per board size
+// and clue percentage, the groups of the summary CSVs written by
+// run_solver.py, and are written in the same layout with median and tail
+// times added as extra columns:
+//   Type,Clue %,Total Instances,Successes,Success Rate (%),Avg Time,
+//   Std Dev Time,Cycles,Median Time,P90 Time,P99 Time
+// As there, the time and cycle figures are over the successful runs only
+// and the standard deviation is the sample one.
+//
+struct BenchGroup
+{
+	int numUnits;
+	int cluePercent;
+	int total;			// runs
+	int successes;
+	double meanTime;
+	double stdTime;
+	double cycles;		// mean
+	double medianTime;
+	double p90Time;
+	double p99Time;
+	std::vector<double> times;	// of each successful run, not kept in the CSV
+};
+
+// Solve every puzzle runs times, one after another on this thread, through
+// one context per board size. Each size's first puzzle is first solved
+// warmup times unmeasured, so that buffers are allocated and caches warm.
+// Run r of puzzle i is seeded with seed + i*runs + r, so that any run can
+// be repeated on its own. If progress is not null a line is written to it
+// as each group finishes.
+std::vector<BenchGroup> RunBenchmark( const PuzzleSource &puzzles, const SolverOptions &opt, int runs, int warmup, unsigned int seed, std::ostream *progress );
+
+void WriteBenchCsv( const std::vector<BenchGroup> &groups, std::ostream &out );
+// a CSV in the layout above, or an older one without the extra columns;
+// false if it cannot be read
+bool ReadBenchCsv( const std::string &fileName, std::vector<BenchGroup> &groups );
+
+// For each group in both, test whether the current mean time differs from
+// the baseline (Welch's t-test, from the means, deviations and success
+// counts alone) and whether the success rate does (two-proportion z-test),
+// and write a table of the changes to out. Returns the number of groups
+// significantly worse at level alpha: slower, or solving fewer.
+int CompareBench( const std::vector<BenchGroup> &baseline, const std::vector<BenchGroup> &current, double alpha, std::ostream &out );
+
+// two-sided p-value of Welch's t-test for two samples given as mean,
+// standard deviation and size; t and df receive the statistic and the
+// Welch-Satterthwaite degrees of freedom
+double WelchTest( double mean1, double sd1, int n1, double mean2, double sd2, int n2, double &t, double &df );
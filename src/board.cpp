@@ -7,10 +7,10 @@
 //
 // description of a sudoku board, with functions for setting cells and propagating constraints
 //
-Board::Board(const string &puzzleString)
+Board::Board(const char *puzzle, int length)
 {
 	// check this is a supported puzzle size
-	switch (puzzleString.length())
+	switch (length)
 	{
 	case 36:    // 6x6
 		order = 0;  // Not a square grid
@@ -89,39 +89,40 @@ Board::Board(const string &puzzleString)
 	numFixedCells = 0;
 	for (int i = 0; i < numCells; i++)
 	{
-		if (puzzleString[i] != '.')
+		// '0' is also blank on grids which do not use it as a digit
+		if (puzzle[i] != '.' && !(numUnits <= 9 && puzzle[i] == '0'))
 		{
 			int value;
 			if (numUnits == 6)
 			{
 				// 6x6: use '1'-'6'
-				value = (int)(puzzleString[i] - '0');
+				value = (int)(puzzle[i] - '0');
 			}
 			else if (numUnits == 9)
 			{
 				// 9x9: use '1'-'9'
-				value = (int)(puzzleString[i] - '0');
+				value = (int)(puzzle[i] - '0');
 			}
 			else if (numUnits == 12)
 			{
 				// 12x12: use '0'-'9' then 'a'-'b'
-				if (puzzleString[i] >= '0' && puzzleString[i] <= '9')
-					value = 1 + (int)(puzzleString[i] - '0');
+				if (puzzle[i] >= '0' && puzzle[i] <= '9')
+					value = 1 + (int)(puzzle[i] - '0');
 				else
-					value = 11 + (int)(puzzleString[i] - 'a');
+					value = 11 + (int)(puzzle[i] - 'a');
 			}
 			else if (numUnits == 16)
 			{
 				// 16x16: use '0'-'9' then 'a'-'f'
-				if (puzzleString[i] >= '0' && puzzleString[i] <= '9')
-					value = 1 + (int)(puzzleString[i] - '0');
+				if (puzzle[i] >= '0' && puzzle[i] <= '9')
+					value = 1 + (int)(puzzle[i] - '0');
 				else
-					value = 11 + (int)(puzzleString[i] - 'a');
+					value = 11 + (int)(puzzle[i] - 'a');
 			}
 			else
 			{
 				// 25x25 and larger: use 'a'-'y', etc.
-				value = 1 + (int)(puzzleString[i] - 'a');
+				value = 1 + (int)(puzzle[i] - 'a');
 			}
 			SetCell( i, ValueSet(maxVal, (int64_t)1 << (value-1) ));
 			isClue[i] = true;
@@ -136,6 +137,12 @@ Board::Board(const Board &other)
 
 void Board::Copy(const Board& other)
 {
+	if (cells != nullptr && numCells != other.numCells)
+	{
+		// different geometry, the cells need reallocating
+		delete [] cells;
+		cells = nullptr;
+	}
 	order = other.order;
 	boxRows = other.boxRows;
 	boxCols = other.boxCols;
@@ -257,7 +264,9 @@ string Board::AsString(bool useNumbers, bool showUnfixed )
 			else
 				cellContents = cells[i].toString(alphabet);
 		}
-		else 
+		else if ( !cells[i].Fixed() )
+			cellContents = string(".");
+		else
 			cellContents = to_string(cells[i].Index() + 1);
 		if (cellContents.size() > maxLen )
 			maxLen = cellContents.size();
@@ -337,7 +346,10 @@ void Board::ConstrainCell(int i )
 	else
 	{
 		// eliminate all the values already taken in this cell's units
+		int before = changeLog != nullptr ? cells[i].Count() : 0;
 		cells[i] ^= fixedCellsConstraint;
+		if (changeLog != nullptr && cells[i].Count() != before)
+			changeLog->push_back(i);
 		// are any of the remaining values for this cell in the only possible
 		// place in a unit? If so, set the cell to that value
 		if ((cells[i]-rowAll).Fixed())
@@ -358,6 +370,8 @@ void Board::SetCell(int i, const ValueSet &c )
 	// set the cell
 	cells[i] = c;
 	++numFixedCells;
+	if (changeLog != nullptr)
+		changeLog->push_back(i);
 	// propagate the constraints
   	int iBox, iCol, iRow;
 	iBox = BoxForCell(i);
@@ -404,6 +418,37 @@ int Board::GetNumUnits(void) const
 	return numUnits;
 }
 
+int Board::ConflictCount() const
+{
+	int conflicts = 0;
+	for (int i = 0; i < numUnits; i++)
+	{
+		ValueSet row(numUnits), col(numUnits), box(numUnits);
+		for (int j = 0; j < numUnits; j++)
+		{
+			const ValueSet &r = cells[RowCell(i, j)];
+			const ValueSet &c = cells[ColCell(i, j)];
+			const ValueSet &b = cells[BoxCell(i, j)];
+			if (r.Fixed())
+			{
+				conflicts += row.Contains(r);
+				row += r;
+			}
+			if (c.Fixed())
+			{
+				conflicts += col.Contains(c);
+				col += c;
+			}
+			if (b.Fixed())
+			{
+				conflicts += box.Contains(b);
+				box += b;
+			}
+		}
+	}
+	return conflicts;
+}
+
 bool Board::CheckSolution(const Board& other) const
 {
 	// check that other is 1/ a solution, 2/ consistent with this board
@@ -452,11 +497,15 @@ bool Board::CheckSolution(const Board& other) const
 void Board::ForceSetCell(int i, const ValueSet &c)
 {
     // Directly set the cell value, even if it's fixed
+    bool wasFixed = cells[i].Fixed();
+    bool wasEmpty = cells[i].Empty();
     cells[i] = c;
 
     // Update bookkeeping if needed
-    if (!cells[i].Fixed()) 
-        ++numFixedCells;
+    if (cells[i].Fixed() != wasFixed)
+        numFixedCells += wasFixed ? -1 : 1;
+    if (cells[i].Empty() != wasEmpty)
+        numInfeasible += wasEmpty ? -1 : 1;
 
     // Propagate constraints like in SetCell
     int iBox = BoxForCell(i);
@@ -481,6 +530,18 @@ void Board::ForceSetCell(int i, const ValueSet &c)
     }
 }
 
+void Board::SetCellUnpropagated(int i, const ValueSet &c)
+{
+    // like ForceSetCell, but the neighbours are left alone
+    bool wasFixed = cells[i].Fixed();
+    bool wasEmpty = cells[i].Empty();
+    cells[i] = c;
+    if (cells[i].Fixed() != wasFixed)
+        numFixedCells += wasFixed ? -1 : 1;
+    if (cells[i].Empty() != wasEmpty)
+        numInfeasible += wasEmpty ? -1 : 1;
+}
+
 bool Board::IsClue(int i) const
 {
 	return isClue.at(i);
@@ -9,15 +9,19 @@ class Board
 public:
 	// sudoku board
 	Board(){};
-	Board(const string &puzzleString);
+	Board(const string &puzzleString) : Board(puzzleString.data(), (int)puzzleString.length()) {}
+	Board(const char *puzzle, int length);	// puzzle need not be null terminated
 	Board(const Board &other);
 	~Board();
+	Board &operator=(const Board &other) { if (this != &other) Copy(other); return *this; }
 
 	string AsString(bool useNmbers=false, bool showUnfixed = false);
 	int FixedCellCount(void) const;
 	int InfeasibleCellCount(void) const;
+	int ConflictCount(void) const;	// fixed cells repeating a value earlier in their row, column or box
 	void SetCell(int i, const ValueSet &c );
 	void ForceSetCell(int i, const ValueSet &c );
+	void SetCellUnpropagated(int i, const ValueSet &c );	// e.g. to fill in a known solution
 	const ValueSet &GetCell(int i) const;
 	
 
@@ -38,9 +42,13 @@ public:
 	bool IsClue(int i) const;
 	bool IsEmpty(int cell);
 
+	// if set, the index of every cell whose possibilities shrink is appended to log
+	void SetChangeLog(std::vector<int> *log) { changeLog = log; }
+
 
 private:
 	ValueSet *cells = nullptr;
+	std::vector<int> *changeLog = nullptr; // not copied by Copy()
 
 	int order;   // order of puzzle
 	int boxRows; // height of each box (e.g., 2 for 6x6, 3 for 9x9, 3 for 12x12)
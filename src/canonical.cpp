@@ -0,0 +1,201 @@
+#include "canonical.h"
+#include "puzzleio.h"
+#include <algorithm>
+
+namespace
+{
+	typedef std::vector<int> Signature;
+
+	// order of units, strongest signature first, ties kept in their original order
+	std::vector<int> OrderBySignature(const std::vector<Signature> &sig, const std::vector<int> &units)
+	{
+		std::vector<int> order(units);
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return sig[a] > sig[b]; });
+		return order;
+	}
+
+	// rank of each signature among the distinct signatures
+	std::vector<int> Classes(const std::vector<Signature> &sig)
+	{
+		std::vector<Signature> distinct(sig);
+		std::sort(distinct.begin(), distinct.end());
+		distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+		std::vector<int> classes(sig.size());
+		for (size_t k = 0; k < sig.size(); k++)
+			classes[k] = (int)(std::lower_bound(distinct.begin(), distinct.end(), sig[k]) - distinct.begin());
+		return classes;
+	}
+
+	// lines (rows, or columns) of each group (band, or stack) put in canonical order
+	std::vector<int> OrderLines(const std::vector<Signature> &lineSig, int numGroups, int groupSize)
+	{
+		std::vector<Signature> groupSig(numGroups);
+		std::vector<std::vector<int>> groupLines(numGroups);
+		std::vector<int> groups(numGroups);
+		for (int g = 0; g < numGroups; g++)
+		{
+			std::vector<int> lines(groupSize);
+			for (int k = 0; k < groupSize; k++)
+				lines[k] = g*groupSize + k;
+			groupLines[g] = OrderBySignature(lineSig, lines);
+			for (int line : groupLines[g])
+				groupSig[g].insert(groupSig[g].end(), lineSig[line].begin(), lineSig[line].end());
+			groups[g] = g;
+		}
+		std::vector<int> order;
+		for (int g : OrderBySignature(groupSig, groups))
+			order.insert(order.end(), groupLines[g].begin(), groupLines[g].end());
+		return order;
+	}
+}
+
+CanonicalForm Canonicalise(const Board &puzzle)
+{
+	CanonicalForm best;
+	best.numUnits = 0;
+	best.hash = 0;
+	int numCells = puzzle.CellCount();
+	int n, boxRows, boxCols;
+	if (!PuzzleGeometry(numCells, n, boxRows, boxCols))
+		return best;
+
+	// givens as values 1..n, 0 for blank
+	std::vector<int> given(numCells, 0);
+	for (int i = 0; i < numCells; i++)
+	{
+		if (puzzle.IsClue(i))
+			given[i] = puzzle.GetCell(i).Index() + 1;
+		if (given[i] > n)
+			return best;
+	}
+
+	int numOrientations = boxRows == boxCols ? 2 : 1;
+	for (int t = 0; t < numOrientations; t++)
+	{
+		// cell of the (possibly transposed) grid at row r, column c
+		auto cellAt = [&](int r, int c) { return t ? c*n + r : r*n + c; };
+
+		// a line's signature is its clue count, then for each of its clues
+		// the class of the crossing line and how often the digit is given,
+		// largest first. Classes (the rank of a line's signature among
+		// the distinct ones) start equal and are refined a few times.
+		std::vector<int> digitCount(n + 1, 0);
+		for (int i = 0; i < numCells; i++)
+			digitCount[given[i]]++;
+		std::vector<int> rowClass(n, 0), colClass(n, 0);
+		std::vector<Signature> rowSig(n), colSig(n);
+		for (int round = 0; round < 3; round++)
+		{
+			for (int k = 0; k < n; k++)
+			{
+				rowSig[k].clear();
+				colSig[k].clear();
+			}
+			for (int r = 0; r < n; r++)
+			{
+				for (int c = 0; c < n; c++)
+				{
+					int v = given[cellAt(r, c)];
+					if (v)
+					{
+						rowSig[r].push_back(colClass[c]*(numCells + 1) + digitCount[v]);
+						colSig[c].push_back(rowClass[r]*(numCells + 1) + digitCount[v]);
+					}
+				}
+			}
+			for (int k = 0; k < n; k++)
+			{
+				std::sort(rowSig[k].rbegin(), rowSig[k].rend());
+				rowSig[k].insert(rowSig[k].begin(), (int)rowSig[k].size());
+				std::sort(colSig[k].rbegin(), colSig[k].rend());
+				colSig[k].insert(colSig[k].begin(), (int)colSig[k].size());
+			}
+			rowClass = Classes(rowSig);
+			colClass = Classes(colSig);
+		}
+		std::vector<int> rows = OrderLines(rowSig, n / boxRows, boxRows);
+		std::vector<int> cols = OrderLines(colSig, n / boxCols, boxCols);
+
+		// digits numbered in order of first appearance
+		CanonicalForm form;
+		form.numUnits = n;
+		form.givens.assign(numCells, '.');
+		form.cellMap.resize(numCells);
+		form.valueMap.assign(n, -1);
+		std::vector<int> label(n + 1, 0);
+		int numLabels = 0;
+		for (int r = 0; r < n; r++)
+		{
+			for (int c = 0; c < n; c++)
+			{
+				int cell = cellAt(rows[r], cols[c]);
+				form.cellMap[r*n + c] = cell;
+				int v = given[cell];
+				if (v == 0)
+					continue;
+				if (label[v] == 0)
+				{
+					label[v] = ++numLabels;
+					form.valueMap[numLabels - 1] = v - 1;
+				}
+				form.givens[r*n + c] = PuzzleValueChar(label[v], n);
+			}
+		}
+		// digits with no givens take the remaining labels in order
+		for (int v = 1; v <= n; v++)
+		{
+			if (label[v] == 0)
+			{
+				label[v] = ++numLabels;
+				form.valueMap[numLabels - 1] = v - 1;
+			}
+		}
+		if (t == 0 || form.givens < best.givens)
+			best = form;
+	}
+	best.hash = CanonicalHash(best.givens);
+	return best;
+}
+
+std::string ToCanonical(const CanonicalForm &form, const Board &solution)
+{
+	int numCells = (int)form.cellMap.size();
+	std::vector<int> label(form.numUnits);
+	for (int k = 0; k < form.numUnits; k++)
+		label[form.valueMap[k]] = k + 1;
+	std::string s(numCells, '.');
+	for (int i = 0; i < numCells; i++)
+	{
+		const ValueSet &cell = solution.GetCell(form.cellMap[i]);
+		if (cell.Fixed())
+			s[i] = PuzzleValueChar(label[cell.Index()], form.numUnits);
+	}
+	return s;
+}
+
+Board FromCanonical(const CanonicalForm &form, const std::string &solution, const Board &puzzle)
+{
+	// set straight over a copy of the puzzle, without the propagation
+	// parsing a new board would do
+	Board sol(puzzle);
+	int numCells = (int)form.cellMap.size();
+	for (int i = 0; i < numCells && i < (int)solution.length(); i++)
+	{
+		int v = PuzzleCharValue(solution[i], form.numUnits);
+		if (v > 0 && v <= form.numUnits)
+			sol.SetCellUnpropagated(form.cellMap[i], ValueSet(form.numUnits, (uint64_t)1 << form.valueMap[v - 1]));
+	}
+	return sol;
+}
+
+uint64_t CanonicalHash(const std::string &givens)
+{
+	// FNV-1a
+	uint64_t h = 14695981039346656037ULL;
+	for (char c : givens)
+	{
+		h ^= (unsigned char)c;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "board.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+//
+// Canonical form of a puzzle's givens under the sudoku symmetries which keep
+// the geometry: permuting bands, stacks, the rows in a band and the columns
+// in a stack, transposing (square boxes only) and relabelling digits.
+//
+// Rows and columns are ordered by signatures built from clue counts, which
+// do not change under those symmetries, then digits are numbered in order
+// of appearance.
+// Equivalent puzzles get the same form unless the signatures tie, in which
+// case the original order breaks the tie and they may not. The mapping is
+// always a true symmetry, so solutions can be moved between a puzzle and its
+// canonical form either way.
+//
+struct CanonicalForm
+{
+	int numUnits;
+	std::string givens;			// puzzle string of the canonical givens
+	std::vector<int> cellMap;	// canonical cell -> original cell
+	std::vector<int> valueMap;	// canonical value -> original value, both 0-based
+	uint64_t hash;				// of givens
+};
+
+CanonicalForm Canonicalise(const Board &puzzle);
+uint64_t CanonicalHash(const std::string &givens);
+
+// a solution of the original puzzle as a canonical puzzle string, and back
+// (filled in over the original puzzle)
+std::string ToCanonical(const CanonicalForm &form, const Board &solution);
+Board FromCanonical(const CanonicalForm &form, const std::string &solution, const Board &puzzle);
@@ -0,0 +1,174 @@
+#include "packedarchive.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+using namespace std;
+
+static const char packedMagic[8] = { 'S','U','D','O','K','P','A','K' };
+static const uint32_t packedVersion = 1;
+
+static int BitsPerValue( int numUnits )
+{
+	// enough for 0..numUnits
+	int bits = 1;
+	while ( (1 << bits) <= numUnits )
+		++bits;
+	return bits;
+}
+
+static bool ValidEntry( const PackedEntry &entry, const PackedHeader &header, const MappedFile &file )
+{
+	// a supported box shape with its bits per value, packed data between the
+	// header and the index, and a name that ends before the file does
+	int numUnits, boxRows, boxCols;
+	int units = entry.boxRows * entry.boxCols;
+	if ( !PuzzleGeometry(units * units, numUnits, boxRows, boxCols) || boxRows != entry.boxRows ||
+		boxCols != entry.boxCols || entry.bitsPerValue != BitsPerValue(units) )
+		return false;
+	uint64_t dataSize = ((uint64_t)units * units * entry.bitsPerValue + 7) / 8;
+	if ( entry.dataOffset < sizeof(PackedHeader) || entry.dataOffset + dataSize > header.indexOffset )
+		return false;
+	uint64_t namesSize = file.Size() - header.namesOffset;
+	return entry.nameOffset < namesSize &&
+		memchr(file.Data() + header.namesOffset + entry.nameOffset, '\0', namesSize - entry.nameOffset) != nullptr;
+}
+
+bool WritePackedArchive( const string &fileName, const PuzzleSource &puzzles )
+{
+	ofstream out(fileName, ios::binary);
+	if ( !out.is_open() )
+	{
+		cerr << "could not create archive: " << fileName << endl;
+		return false;
+	}
+	PackedHeader header;
+	memcpy(header.magic, packedMagic, sizeof(packedMagic));
+	header.version = packedVersion;
+	header.numPuzzles = 0;
+	out.write((const char *)&header, sizeof(header));
+
+	vector<PackedEntry> index;
+	string names;
+	vector<uint8_t> packed;
+	uint64_t offset = sizeof(header);
+	for ( int i = 0; i < puzzles.Count(); i++ )
+	{
+		ostringstream name;
+		puzzles.Name(i, name);
+		int length;
+		const char *text = puzzles.Text(i, length);
+		int numUnits, boxRows, boxCols;
+		if ( !PuzzleGeometry(length, numUnits, boxRows, boxCols) )
+		{
+			cerr << "skipping " << name.str() << ": unsupported size" << endl;
+			continue;
+		}
+
+		PackedEntry entry;
+		entry.dataOffset = offset;
+		entry.nameOffset = (uint32_t)names.length();
+		entry.boxRows = (uint8_t)boxRows;
+		entry.boxCols = (uint8_t)boxCols;
+		entry.bitsPerValue = (uint8_t)BitsPerValue(numUnits);
+
+		packed.assign(((size_t)length * entry.bitsPerValue + 7) / 8, 0);
+		int numClues = 0;
+		for ( int k = 0; k < length; k++ )
+		{
+			uint32_t v = (uint32_t)PuzzleCharValue(text[k], numUnits);
+			if ( v != 0 )
+				++numClues;
+			size_t bit = (size_t)k * entry.bitsPerValue;
+			for ( int b = 0; b < entry.bitsPerValue; b++, bit++ )
+			{
+				if ( (v >> b) & 1 )
+					packed[bit / 8] |= (uint8_t)(1 << (bit % 8));
+			}
+		}
+		entry.cluePercent = (uint8_t)NominalCluePercent(name.str(), numClues, length);
+		out.write((const char *)packed.data(), packed.size());
+		offset += packed.size();
+		names += name.str();
+		names += '\0';
+		index.push_back(entry);
+	}
+
+	header.numPuzzles = (uint32_t)index.size();
+	header.indexOffset = offset;
+	header.namesOffset = offset + index.size() * sizeof(PackedEntry);
+	out.write((const char *)index.data(), index.size() * sizeof(PackedEntry));
+	out.write(names.data(), names.length());
+	out.seekp(0);
+	out.write((const char *)&header, sizeof(header));
+	return out.good();
+}
+
+PackedArchive::PackedArchive( const string &fileName, int numUnits, int minClues, int maxClues ) :
+	fileName(fileName), names(nullptr)
+{
+	if ( !file.Open(fileName) )
+	{
+		cerr << "could not open archive: " << fileName << endl;
+		return;
+	}
+	PackedHeader header;
+	const char *data = file.Data();
+	if ( file.Size() < sizeof(header) )
+	{
+		cerr << "not a puzzle archive: " << fileName << endl;
+		file.Close();
+		return;
+	}
+	memcpy(&header, data, sizeof(header));
+	if ( memcmp(header.magic, packedMagic, sizeof(packedMagic)) != 0 || header.version != packedVersion ||
+		header.namesOffset > file.Size() || header.indexOffset + (uint64_t)header.numPuzzles * sizeof(PackedEntry) > header.namesOffset )
+	{
+		cerr << "not a puzzle archive: " << fileName << endl;
+		file.Close();
+		return;
+	}
+	names = data + header.namesOffset;
+
+	bool valid = true;
+	for ( uint32_t i = 0; i < header.numPuzzles && valid; i++ )
+	{
+		PackedEntry entry;
+		memcpy(&entry, data + header.indexOffset + (uint64_t)i * sizeof(PackedEntry), sizeof(entry));
+		if ( !ValidEntry(entry, header, file) )
+		{
+			valid = false;
+			break;
+		}
+		int units = entry.boxRows * entry.boxCols;
+		if ( (numUnits != 0 && units != numUnits) || entry.cluePercent < minClues || entry.cluePercent > maxClues )
+			continue;
+
+		int length = units * units;
+		const uint8_t *packed = (const uint8_t *)data + entry.dataOffset;
+		textStart.push_back(text.length());
+		textLength.push_back(length);
+		nameOffset.push_back(entry.nameOffset);
+		size_t bit = 0;
+		for ( int k = 0; k < length; k++ )
+		{
+			int v = 0;
+			for ( int b = 0; b < entry.bitsPerValue; b++, bit++ )
+				v |= ((packed[bit / 8] >> (bit % 8)) & 1) << b;
+			if ( v > units )
+				valid = false;
+			text += PuzzleValueChar(v, units);
+		}
+	}
+	if ( !valid )
+	{
+		cerr << "not a puzzle archive: " << fileName << endl;
+		text.clear();
+		textStart.clear();
+		textLength.clear();
+		nameOffset.clear();
+		names = nullptr;
+		file.Close();
+	}
+}
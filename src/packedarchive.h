@@ -0,0 +1,58 @@
+#pragma once
+#include "puzzleio.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+//
+// Packed binary archive of puzzle instances, so that a whole corpus can be
+// loaded with one read (or mapping) instead of a file per instance.
+// Layout, little-endian:
+//   header  PackedHeader
+//   data    each puzzle's cell values (0 for blank, else 1..numUnits),
+//           bitsPerValue bits each, least significant bit first, starting
+//           on a byte boundary
+//   index   one PackedEntry per puzzle, for random access
+//   names   null-terminated names (the original file paths)
+//
+struct PackedHeader
+{
+	char magic[8];	// "SUDOKPAK"
+	uint32_t version;
+	uint32_t numPuzzles;
+	uint64_t indexOffset;
+	uint64_t namesOffset;
+};
+
+struct PackedEntry
+{
+	uint64_t dataOffset;
+	uint32_t nameOffset;	// from namesOffset
+	uint8_t boxRows;
+	uint8_t boxCols;
+	uint8_t bitsPerValue;
+	uint8_t cluePercent;	// nominal percentage of given cells
+};
+
+// write every puzzle from source to an archive, false on failure
+bool WritePackedArchive(const std::string &fileName, const PuzzleSource &puzzles);
+
+// the puzzles of an archive, optionally only those with numUnits x numUnits
+// cells (0 for any size) and a clue percentage from minClues to maxClues.
+// The selected puzzles are unpacked to puzzle strings when loading.
+class PackedArchive : public PuzzleSource
+{
+	std::string fileName;
+	MappedFile file;
+	const char *names;
+	std::string text;	// selected puzzle strings, back to back
+	std::vector<size_t> textStart;
+	std::vector<int> textLength;
+	std::vector<uint32_t> nameOffset;
+public:
+	PackedArchive(const std::string &fileName, int numUnits = 0, int minClues = 0, int maxClues = 100);
+	bool IsOpen() const { return file.IsOpen(); }
+	virtual int Count() const { return (int)textStart.size(); }
+	virtual const char *Text(int i, int &length) const { length = textLength[i]; return text.data() + textStart[i]; }
+	virtual void Name(int i, std::ostream &out) const { out << names + nameOffset[i]; }
+};
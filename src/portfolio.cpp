@@ -0,0 +1,101 @@
+#include "portfolio.h"
+#include "random.h"
+#include <thread>
+#include <chrono>
+using namespace std;
+
+PortfolioSolver::PortfolioSolver() : cancel(false), winner(-1), numFinished(0), solTime(0.0f), cycles(0)
+{
+}
+
+PortfolioSolver::~PortfolioSolver()
+{
+	for ( auto s : solvers )
+		delete s;
+}
+
+void PortfolioSolver::AddSolver(SudokuSolver *solver)
+{
+	solver->SetStopFlag(&cancel);
+	solvers.push_back(solver);
+}
+
+void PortfolioSolver::SetWarmStart(const Board &previous)
+{
+	for ( auto s : solvers )
+		s->SetWarmStart(previous);
+}
+
+void PortfolioSolver::SetSeed(unsigned int seed)
+{
+	for ( size_t s = 0; s < solvers.size(); s++ )
+		solvers[s]->SetSeed(DeriveSeed(seed, (uint32_t)s));
+}
+
+bool PortfolioSolver::Solve(const Board& puzzle, float maxTime)
+{
+	solutionTimer.Reset();
+	cancel = false;
+	winner = -1;
+	numFinished = 0;
+	cycles = 0;
+	sol.Copy(puzzle);
+
+	auto run = [&](int s)
+	{
+		// each solver gets its own copy of the puzzle
+		Board local(puzzle);
+		bool success = solvers[s]->Solve(local, maxTime);
+		if ( success && !puzzle.CheckSolution(solvers[s]->GetSolution()) )
+			success = false;
+		lock_guard<mutex> lock(winMutex);
+		if ( success && winner < 0 )
+		{
+			winner = s;
+			cancel = true;
+		}
+		++numFinished;
+		winSignal.notify_one();
+	};
+	vector<thread> threads;
+	for ( int s = 0; s < (int)solvers.size(); s++ )
+		threads.push_back(thread(run, s));
+
+	// wait for a winner or for every solver to give up, passing on any
+	// request to stop this solver to the ones it is running
+	{
+		unique_lock<mutex> lock(winMutex);
+		while ( winner < 0 && numFinished < (int)solvers.size() )
+		{
+			if ( StopRequested() )
+				cancel = true;
+			winSignal.wait_for(lock, chrono::milliseconds(10));
+		}
+	}
+	cancel = true;
+	for ( auto &t : threads )
+		t.join();
+	solTime = solutionTimer.Elapsed();
+
+	if ( winner < 0 )
+	{
+		// nobody finished: keep the best partial board, fewest conflicts
+		// then most cells filled
+		int best = 0;
+		for ( int s = 1; s < (int)solvers.size(); s++ )
+		{
+			const Board &b = solvers[s]->GetSolution();
+			const Board &bb = solvers[best]->GetSolution();
+			if ( b.ConflictCount() < bb.ConflictCount() ||
+				(b.ConflictCount() == bb.ConflictCount() && b.FixedCellCount() > bb.FixedCellCount()) )
+				best = s;
+		}
+		sol.Copy(solvers[best]->GetSolution());
+		trace = solvers[best]->GetTrace();
+		return false;
+	}
+	sol.Copy(solvers[winner]->GetSolution());
+	trace = solvers[winner]->GetTrace();
+	cycles = solvers[winner]->GetCycles();
+	return true;
+}
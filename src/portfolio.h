@@ -0,0 +1,43 @@
+#pragma once
+#include "board.h"
+#include "sudokusolver.h"
+#include "timer.h"
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+//
+// Races several solvers on the same puzzle, one thread each, and keeps the
+// first verified solution. The solvers share a stop token, which is set as
+// soon as one of them wins (or the portfolio itself is asked to stop), and
+// each solver checks it in its inner loop, so the losers return promptly.
+//
+class PortfolioSolver : public SudokuSolver
+{
+	std::vector<SudokuSolver *> solvers;	// owned
+	std::atomic<bool> cancel;
+	std::mutex winMutex;
+	std::condition_variable winSignal;
+	int winner;
+	int numFinished;
+	Board sol;
+	Timer solutionTimer;
+	float solTime;
+	int cycles;
+public:
+	PortfolioSolver();
+	~PortfolioSolver();
+	// takes ownership of the solver
+	void AddSolver(SudokuSolver *solver);
+	int NumSolvers() const { return (int)solvers.size(); }
+	// index of the solver which found the last solution, -1 if none did
+	int GetWinner() const { return winner; }
+	virtual void SetWarmStart(const Board &previous);
+	// member s is seeded with stream s of the seed
+	virtual void SetSeed(unsigned int seed);
+	virtual bool Solve(const Board& puzzle, float maxTime);
+	virtual float GetSolutionTime() { return solTime; }
+	virtual int GetCycles() { return cycles; }
+	virtual const Board& GetSolution() { return sol; }
+};
@@ -0,0 +1,112 @@
+#include "puzzleeditor.h"
+#include "puzzleio.h"
+#include "timer.h"
+using namespace std;
+
+PuzzleEditor::PuzzleEditor( int numUnits, const SolverOptions &opt ) :
+	numUnits(numUnits), solver(nullptr), timeOut(opt.timeOut), hasSolution(false), solved(false), reused(false), solTime(0.0f), cycles(0)
+{
+	int units, boxRows, boxCols;
+	if ( !PuzzleGeometry(numUnits * numUnits, units, boxRows, boxCols) )
+		return;
+	trail.push_back(Board(string(numUnits * numUnits, '.')));
+	solver = CreateSolver(opt, trail.back());
+}
+
+PuzzleEditor::~PuzzleEditor()
+{
+	delete solver;
+}
+
+bool PuzzleEditor::Place( int cell, int value )
+{
+	// propagate the new clue from the current board
+	ValueSet choice(numUnits, (uint64_t)1 << (value - 1));
+	const Board &current = trail.back();
+	if ( current.IsClue(cell) || !current.GetCell(cell).Contains(choice) )
+		return false;
+	Board next(current);
+	next.SetCell(cell, choice);
+	if ( next.InfeasibleCellCount() != 0 )
+		return false;
+	next.isClue[cell] = true;
+	trail.push_back(next);
+	clueCell.push_back(cell);
+	clueValue.push_back(value);
+	return true;
+}
+
+bool PuzzleEditor::AddClue( int cell, int value )
+{
+	if ( solver == nullptr || cell < 0 || cell >= numUnits * numUnits || value < 1 || value > numUnits )
+		return false;
+	if ( trail.back().IsClue(cell) )
+	{
+		int old = 0;
+		for ( size_t k = 0; k < clueCell.size(); k++ )
+		{
+			if ( clueCell[k] == cell )
+				old = clueValue[k];
+		}
+		if ( old == value )
+			return true;
+		RemoveClue(cell);
+		if ( !Place(cell, value) )
+		{
+			Place(cell, old);
+			return false;
+		}
+	}
+	else if ( !Place(cell, value) )
+		return false;
+	solved = hasSolution && trail.back().CheckSolution(solution);
+	return true;
+}
+
+bool PuzzleEditor::RemoveClue( int cell )
+{
+	int k = 0;
+	while ( k < (int)clueCell.size() && clueCell[k] != cell )
+		++k;
+	if ( k == (int)clueCell.size() )
+		return false;
+
+	// back to the board from before the clue, then replay the later ones
+	vector<int> laterCell(clueCell.begin() + k + 1, clueCell.end());
+	vector<int> laterValue(clueValue.begin() + k + 1, clueValue.end());
+	trail.resize(k + 1);
+	clueCell.resize(k);
+	clueValue.resize(k);
+	for ( size_t j = 0; j < laterCell.size(); j++ )
+		Place(laterCell[j], laterValue[j]);
+	// removing a clue cannot invalidate a solution
+	return true;
+}
+
+bool PuzzleEditor::Solve()
+{
+	if ( solver == nullptr )
+		return false;
+	const Board &puzzle = trail.back();
+	Timer solveTimer;
+	solveTimer.Reset();
+	reused = hasSolution && (solved || puzzle.CheckSolution(solution));
+	if ( reused )
+	{
+		solved = true;
+		solTime = solveTimer.Elapsed();
+		cycles = 0;
+		return true;
+	}
+	if ( hasSolution )
+		solver->SetWarmStart(solution);
+	solved = solver->Solve(puzzle, timeOut) && puzzle.CheckSolution(solver->GetSolution());
+	solTime = solver->GetSolutionTime();
+	cycles = solver->GetCycles();
+	if ( solved )
+	{
+		solution = solver->GetSolution();
+		hasSolution = true;
+	}
+	return solved;
+}
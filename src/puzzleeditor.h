@@ -0,0 +1,55 @@
+#pragma once
+#include "solveroptions.h"
+#include "board.h"
+#include <vector>
+
+//
+// A puzzle edited one clue at a time, for editors which re-solve after every
+// change. The propagated board after each clue is kept on a trail, so adding
+// a clue propagates from the current board, and removing one replays only
+// the clues added after it onto the board from before it. Solving reuses
+// the last solution outright if it still fits the givens, and otherwise
+// hands it to the solver as a warm start (pheromone for ACS, value order for
+// backtracking).
+//
+// Cells are numbered row by row from 0, values run from 1 to numUnits.
+//
+class PuzzleEditor
+{
+	int numUnits;
+	std::vector<Board> trail;	// trail[k]: the blank board with the first k clues
+	std::vector<int> clueCell;	// in the order they were added
+	std::vector<int> clueValue;
+	SudokuSolver *solver;
+	float timeOut;
+	Board solution;
+	bool hasSolution;	// solution is the last one found, for some earlier givens
+	bool solved;		// solution fits the current givens
+	bool reused;		// the last solve kept the previous solution
+	float solTime;
+	int cycles;
+	PuzzleEditor(const PuzzleEditor &);
+	PuzzleEditor &operator=(const PuzzleEditor &);
+
+	bool Place(int cell, int value);
+public:
+	PuzzleEditor(int numUnits, const SolverOptions &opt);
+	~PuzzleEditor();
+	bool IsValid() const { return solver != nullptr; }
+	int GetNumUnits() const { return numUnits; }
+
+	// false, leaving the puzzle as it was, if the value is ruled out there
+	// by the other givens. A clue already in the cell is replaced.
+	bool AddClue(int cell, int value);
+	// false if the cell holds no clue
+	bool RemoveClue(int cell);
+	int NumClues() const { return (int)clueCell.size(); }
+	const Board &GetPuzzle() const { return trail.back(); }
+
+	bool Solve();
+	const Board &GetSolution() const { return solution; }
+	bool Reused() const { return reused; }
+	float GetSolutionTime() const { return solTime; }
+	int GetCycles() const { return cycles; }
+	void SetTimeOut(float secs) { timeOut = secs; }
+};
@@ -0,0 +1,375 @@
+#include "puzzleio.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+string ReadFile( string fileName )
+{
+	char *puzString;
+	ifstream inFile;
+	inFile.open(fileName);
+	if ( inFile.is_open() )
+	{
+		int firstNumber, idum;
+		inFile >> firstNumber;
+		inFile >> idum;
+		
+		// Read all values into a vector first
+		vector<int> values;
+		int val;
+		while (inFile >> val)
+		{
+			values.push_back(val);
+		}
+		inFile.close();
+		
+		// Determine format based on number of values
+		int numUnits;
+		bool isOldFormat = false;
+		
+		// Old format: firstNumber is order, has order^4 values
+		// New format: firstNumber is size, has size^2 values
+		if (values.size() == firstNumber * firstNumber * firstNumber * firstNumber)
+		{
+			// Old format (9x9, 16x16, 25x25): firstNumber is order
+			isOldFormat = true;
+			numUnits = firstNumber * firstNumber;
+		}
+		else if (values.size() == firstNumber * firstNumber)
+		{
+			// New format (6x6, 12x12): firstNumber is size
+			isOldFormat = false;
+			numUnits = firstNumber;
+		}
+		else
+		{
+			cerr << "Invalid file format: expected " << firstNumber * firstNumber 
+			     << " or " << firstNumber * firstNumber * firstNumber * firstNumber 
+			     << " values, got " << values.size() << endl;
+			return string();
+		}
+		
+		int numCells = numUnits * numUnits;
+		puzString = new char[numCells+1];
+		
+		for (int i = 0; i < numCells; i++)
+		{
+			val = values[i];
+			if (val == -1)
+				puzString[i] = '.';
+			else if (numUnits == 6)
+				puzString[i] = '1' + (val - 1);  // 1-6 -> '1'-'6'
+			else if (numUnits == 9)
+				puzString[i] = '1' + (val - 1);  // 1-9 -> '1'-'9'
+			else if (numUnits == 12)
+			{
+				if (val <= 10)
+					puzString[i] = '0' + val - 1;  // 1-10 -> '0'-'9'
+				else
+					puzString[i] = 'a' + val - 11;  // 11-12 -> 'a'-'b'
+			}
+			else if (numUnits == 16)
+			{
+				if (val < 11)
+					puzString[i] = '0' + val - 1;
+				else
+					puzString[i] = 'a' + val - 11;
+			}
+			else  // 25x25 and larger
+				puzString[i] = 'a' + val - 1;
+		}
+		puzString[numCells] = 0;
+		inFile.close();
+		string retVal = string(puzString);
+		delete [] puzString;
+		return retVal;
+	}
+	else
+	{
+		cerr << "could not open file: " << fileName << endl;
+		return string();
+	}
+}
+
+static vector<string> ListDirectory( const string &dir, bool &isDir )
+{
+	vector<string> files;
+	isDir = false;
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE h = FindFirstFileA((dir + "\\*").c_str(), &data);
+	if ( h == INVALID_HANDLE_VALUE )
+		return files;
+	isDir = true;
+	do
+	{
+		if ( !(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) )
+			files.push_back(dir + "\\" + data.cFileName);
+	} while ( FindNextFileA(h, &data) );
+	FindClose(h);
+#else
+	DIR *d = opendir(dir.c_str());
+	if ( d == nullptr )
+		return files;
+	isDir = true;
+	struct dirent *entry;
+	while ( (entry = readdir(d)) != nullptr )
+	{
+		string path = dir + "/" + entry->d_name;
+		struct stat st;
+		if ( stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) )
+			files.push_back(path);
+	}
+	closedir(d);
+#endif
+	sort(files.begin(), files.end());
+	return files;
+}
+
+static void ReadList( istream &in, vector<string> &files )
+{
+	string line;
+	while ( getline(in, line) )
+	{
+		// allow for CRLF lists and trailing blanks
+		size_t end = line.find_last_not_of(" \t\r");
+		if ( end != string::npos )
+			files.push_back(line.substr(0, end + 1));
+	}
+}
+
+vector<string> ListInstances( const string &source )
+{
+	vector<string> files;
+	if ( source == "-" )
+	{
+		ReadList(cin, files);
+		return files;
+	}
+	bool isDir;
+	files = ListDirectory(source, isDir);
+	if ( isDir )
+		return files;
+
+	ifstream listFile(source);
+	if ( !listFile.is_open() )
+	{
+		cerr << "could not open instance list: " << source << endl;
+		return files;
+	}
+	ReadList(listFile, files);
+	return files;
+}
+
+InstanceFiles::InstanceFiles( const vector<string> &files ) : files(files)
+{
+	puzzles.resize(files.size());
+	for ( size_t i = 0; i < files.size(); i++ )
+		puzzles[i] = ReadFile(files[i]);
+}
+
+bool MappedFile::Open( const string &fileName )
+{
+	Close();
+#ifdef _WIN32
+	ifstream in(fileName, ios::binary);
+	if ( in.is_open() )
+	{
+		buffer.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+		size = buffer.size();
+		data = size != 0 ? buffer.data() : "";
+	}
+#else
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if ( fd >= 0 )
+	{
+		struct stat st;
+		if ( fstat(fd, &st) == 0 )
+		{
+			size = (size_t)st.st_size;
+			if ( size == 0 )
+				data = "";
+			else
+			{
+				void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if ( p != MAP_FAILED )
+				{
+					madvise(p, size, MADV_SEQUENTIAL);
+					data = (const char *)p;
+				}
+			}
+		}
+		close(fd);
+	}
+#endif
+	return data != nullptr;
+}
+
+void MappedFile::Close()
+{
+#ifndef _WIN32
+	if ( data != nullptr && size != 0 )
+		munmap((void *)data, size);
+#endif
+	buffer.clear();
+	data = nullptr;
+	size = 0;
+}
+
+bool PuzzleGeometry( int length, int &numUnits, int &boxRows, int &boxCols )
+{
+	// the sizes Board supports
+	switch ( length )
+	{
+	case 36:	boxRows = 2; boxCols = 3; break;
+	case 144:	boxRows = 3; boxCols = 4; break;
+	case 81:	boxRows = boxCols = 3; break;
+	case 256:	boxRows = boxCols = 4; break;
+	case 625:	boxRows = boxCols = 5; break;
+	case 1296:	boxRows = boxCols = 6; break;
+	case 2401:	boxRows = boxCols = 7; break;
+	case 4096:	boxRows = boxCols = 8; break;
+	default:
+		return false;
+	}
+	numUnits = boxRows * boxCols;
+	return true;
+}
+
+int PuzzleCharValue( char c, int numUnits )
+{
+	// as parsed by Board
+	if ( c == '.' || (numUnits <= 9 && c == '0') )
+		return 0;
+	if ( numUnits <= 9 )
+		return c - '0';
+	if ( numUnits <= 16 )
+		return c <= '9' ? 1 + c - '0' : 11 + c - 'a';
+	return 1 + c - 'a';
+}
+
+bool ValidPuzzleChars( const char *puzzle, int length, int numUnits )
+{
+	for ( int i = 0; i < length; i++ )
+	{
+		int v = PuzzleCharValue(puzzle[i], numUnits);
+		// 0 only for the blank characters, not for one just below the digits
+		if ( v < 0 || v > numUnits || (v == 0 && puzzle[i] != '.' && puzzle[i] != '0') )
+			return false;
+	}
+	return true;
+}
+
+char PuzzleValueChar( int value, int numUnits )
+{
+	// as written by ReadFile
+	if ( value == 0 )
+		return '.';
+	if ( numUnits <= 9 )
+		return (char)('0' + value);
+	if ( numUnits <= 16 )
+		return (char)(value <= 10 ? '0' + value - 1 : 'a' + value - 11);
+	return (char)('a' + value - 1);
+}
+
+int NominalCluePercent( const string &name, int numClues, int numCells )
+{
+	// generated instances are named inst<size>_<percent>_<n>.txt, otherwise
+	// round the actual percentage
+	size_t base = name.find_last_of("/\\");
+	string file = name.substr(base == string::npos ? 0 : base + 1);
+	size_t first = file.find('_');
+	size_t second = first != string::npos ? file.find('_', first + 1) : string::npos;
+	if ( file.compare(0, 4, "inst") == 0 && second != string::npos )
+	{
+		string pct = file.substr(first + 1, second - first - 1);
+		if ( !pct.empty() && pct.find_first_not_of("0123456789") == string::npos )
+			return atoi(pct.c_str());
+	}
+	return (100 * numClues + numCells / 2) / numCells;
+}
+
+BulkPuzzleFile::BulkPuzzleFile( const string &fileName, int numThreads ) : fileName(fileName)
+{
+	if ( !file.Open(fileName) )
+	{
+		cerr << "could not open bulk puzzle file: " << fileName << endl;
+		return;
+	}
+	FindLines(numThreads);
+}
+
+void BulkPuzzleFile::FindLines( int numThreads )
+{
+	// each thread takes the lines which start in its share of the file, then
+	// the shares are joined in order
+	const char *data = file.Data();
+	size_t size = file.Size();
+	if ( numThreads < 1 )
+		numThreads = 1;
+	if ( size < (size_t)numThreads * 65536 )
+		numThreads = 1;
+	vector<vector<size_t> > starts(numThreads);
+	vector<vector<int> > lengths(numThreads);
+	vector<vector<int> > lines(numThreads);	// line index within the share
+	vector<int> numLines(numThreads);
+	auto scan = [&]( int t )
+	{
+		size_t begin = size * t / numThreads;
+		size_t end = size * (t + 1) / numThreads;
+		size_t pos = begin;
+		if ( pos != 0 && data[pos - 1] != '\n' )
+		{
+			// the line in progress belongs to an earlier share
+			const char *nl = (const char *)memchr(data + pos, '\n', size - pos);
+			pos = nl != nullptr ? nl - data + 1 : size;
+		}
+		int count = 0;
+		while ( pos < end )
+		{
+			const char *nl = (const char *)memchr(data + pos, '\n', size - pos);
+			size_t lineEnd = nl != nullptr ? nl - data : size;
+			size_t len = lineEnd - pos;
+			if ( len != 0 && data[lineEnd - 1] == '\r' )
+				--len;
+			if ( len != 0 && data[pos] != '#' )
+			{
+				starts[t].push_back(pos);
+				lengths[t].push_back((int)len);
+				lines[t].push_back(count);
+			}
+			++count;
+			pos = lineEnd + 1;
+		}
+		numLines[t] = count;
+	};
+	vector<thread> threads;
+	for ( int t = 1; t < numThreads; t++ )
+		threads.push_back(thread(scan, t));
+	scan(0);
+	for ( auto &th : threads )
+		th.join();
+
+	int firstLine = 1;
+	for ( int t = 0; t < numThreads; t++ )
+	{
+		lineStart.insert(lineStart.end(), starts[t].begin(), starts[t].end());
+		lineLength.insert(lineLength.end(), lengths[t].begin(), lengths[t].end());
+		for ( int k : lines[t] )
+			lineNumber.push_back(firstLine + k);
+		firstLine += numLines[t];
+	}
+}
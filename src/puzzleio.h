@@ -0,0 +1,93 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <ostream>
+
+// read a puzzle instance file (order or size, a second number, then one
+// value per cell with -1 for blank) into a puzzle string for Board
+std::string ReadFile( std::string fileName );
+
+// instance files named by source: a directory (its files, sorted by
+// name), "-" for a list of paths on stdin, or a file listing one path per line
+std::vector<std::string> ListInstances( const std::string &source );
+
+//
+// a set of puzzles for batch solving. Text returns the puzzle characters
+// (not null terminated) for Board; Name identifies the puzzle in results.
+//
+class PuzzleSource
+{
+public:
+	virtual ~PuzzleSource() {}
+	virtual int Count() const = 0;
+	virtual const char *Text(int i, int &length) const = 0;
+	virtual void Name(int i, std::ostream &out) const = 0;
+};
+
+// instance files, each read with ReadFile
+class InstanceFiles : public PuzzleSource
+{
+	std::vector<std::string> files;
+	std::vector<std::string> puzzles;
+public:
+	InstanceFiles(const std::vector<std::string> &files);
+	virtual int Count() const { return (int)files.size(); }
+	virtual const char *Text(int i, int &length) const { length = (int)puzzles[i].length(); return puzzles[i].data(); }
+	virtual void Name(int i, std::ostream &out) const { out << files[i]; }
+};
+
+// a whole file in memory: mapped read-only, or read into a buffer where it
+// cannot be mapped
+class MappedFile
+{
+	const char *data;
+	size_t size;
+	std::vector<char> buffer;
+public:
+	MappedFile() : data(nullptr), size(0) {}
+	~MappedFile() { Close(); }
+	bool Open(const std::string &fileName);
+	void Close();
+	bool IsOpen() const { return data != nullptr; }
+	const char *Data() const { return data; }
+	size_t Size() const { return size; }
+};
+
+// puzzle string length and box shape for a board of numUnits x numUnits
+// cells, false if the size is not supported
+bool PuzzleGeometry(int length, int &numUnits, int &boxRows, int &boxCols);
+
+// characters used in puzzle strings: value 1..numUnits, or 0 for a blank
+int PuzzleCharValue(char c, int numUnits);
+char PuzzleValueChar(int value, int numUnits);
+
+// true if every character of the puzzle is a blank or a value 1..numUnits,
+// so Board can parse it without going outside the board's values
+bool ValidPuzzleChars(const char *puzzle, int length, int numUnits);
+
+// clue percentage a puzzle was generated with, from its name (inst9x9_40_3.txt
+// is 40%), or else its actual percentage rounded
+int NominalCluePercent(const std::string &name, int numClues, int numCells);
+
+//
+// bulk file with one puzzle string per line, as used by the public 9x9 and
+// 16x16 corpora ('.' or '0' for blanks on 9x9). The file is memory mapped
+// and puzzles are handed out as pointers into the mapping; the lines are
+// found by numThreads threads, each scanning part of the file. Blank lines
+// and lines starting with '#' are skipped. Puzzles are named file:line.
+//
+class BulkPuzzleFile : public PuzzleSource
+{
+	std::string fileName;
+	MappedFile file;
+	std::vector<size_t> lineStart;	// puzzle starts, in file order
+	std::vector<int> lineLength;
+	std::vector<int> lineNumber;
+	void FindLines(int numThreads);
+public:
+	BulkPuzzleFile(const std::string &fileName, int numThreads = 1);
+	bool IsOpen() const { return file.IsOpen(); }
+	virtual int Count() const { return (int)lineStart.size(); }
+	virtual const char *Text(int i, int &length) const { length = lineLength[i]; return file.Data() + lineStart[i]; }
+	virtual void Name(int i, std::ostream &out) const { out << fileName << ':' << lineNumber[i]; }
+};
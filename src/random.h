@@ -0,0 +1,100 @@
+#pragma once
+#include <random>
+#include <vector>
+#include <cstdint>
+
+//
+// Random numbers for the stochastic solvers. Every solver draws from a
+// RandomGenerator, so a different engine is swapped in here alone; any type
+// meeting the standard's uniform random bit generator requirements with
+// seed(uint32_t) will do, e.g. Xoshiro128 below instead of std::mt19937.
+//
+// With --seed every random stream is derived from the one seed, so that a
+// run can be repeated exactly. Components and threads each get their own
+// stream from DeriveSeed(seed, stream) rather than sharing a generator,
+// so the numbers one draws do not depend on how its work interleaves with
+// the others'.
+//
+
+// xoshiro128** (Blackman and Vigna), 32-bit output: smaller and faster than
+// the Mersenne twister
+class Xoshiro128
+{
+	uint32_t s[4];
+	static uint32_t Rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+public:
+	typedef uint32_t result_type;
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return 0xffffffffu; }
+	explicit Xoshiro128(uint32_t value = 1) { seed(value); }
+	void seed(uint32_t value)
+	{
+		// fill the state with splitmix64, which never gives all zeros
+		uint64_t x = value;
+		for (int k = 0; k < 4; k += 2)
+		{
+			uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			z ^= z >> 31;
+			s[k] = (uint32_t)z;
+			s[k + 1] = (uint32_t)(z >> 32);
+		}
+	}
+	result_type operator()()
+	{
+		uint32_t result = Rotl(s[1] * 5, 7) * 9;
+		uint32_t t = s[1] << 9;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = Rotl(s[3], 11);
+		return result;
+	}
+};
+
+typedef std::mt19937 RandomGenerator;
+
+// seed of stream number stream under seed: a hash of the two, so that
+// neighbouring seeds or streams do not give related sequences
+inline uint32_t DeriveSeed(uint32_t seed, uint32_t stream)
+{
+	uint64_t z = ((uint64_t)seed << 32 | stream) + 0x9e3779b97f4a7c15ULL;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return (uint32_t)(z ^ (z >> 31));
+}
+
+// seed for a run without --seed
+inline uint32_t RandomSeed()
+{
+	std::random_device rd;
+	return rd();
+}
+
+//
+// uniform floats in [0, 1) drawn from a generator a block at a time, for
+// hot loops which take one number per call. Reset after reseeding the
+// generator, so that no numbers from the old sequence are left.
+//
+class UniformBuffer
+{
+	std::vector<float> values;
+	size_t next;
+	std::uniform_real_distribution<float> dist;
+public:
+	explicit UniformBuffer(size_t size = 256) : values(size), next(size), dist(0.0f, 1.0f) {}
+	void Reset() { next = values.size(); }
+	float Next(RandomGenerator &gen)
+	{
+		if (next == values.size())
+		{
+			for (auto &v : values)
+				v = dist(gen);
+			next = 0;
+		}
+		return values[next++];
+	}
+};
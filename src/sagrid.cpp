@@ -0,0 +1,300 @@
+#include "sagrid.h"
+#include <algorithm>
+
+void SAGrid::Init(const Board &board, const Board *domains)
+{
+    hasDomains = domains != nullptr;
+    numUnits = board.GetNumUnits();
+    numCells = board.CellCount();
+
+    value.resize(numCells);
+    movable.resize(numCells);
+    domain.resize(numCells);
+    rowOf.resize(numCells);
+    colOf.resize(numCells);
+    boxOf.resize(numCells);
+    rowCells.resize(numCells);
+    colCells.resize(numCells);
+    boxCells.resize(numCells);
+    for (int u = 0; u < numUnits; u++)
+    {
+        for (int k = 0; k < numUnits; k++)
+        {
+            rowCells[u*numUnits + k] = board.RowCell(u, k);
+            colCells[u*numUnits + k] = board.ColCell(u, k);
+            boxCells[u*numUnits + k] = board.BoxCell(u, k);
+        }
+    }
+    for (int i = 0; i < numCells; i++)
+    {
+        const ValueSet &cell = board.GetCell(i);
+        value[i] = cell.Fixed() ? cell.Index() : -1;
+        movable[i] = !board.IsClue(i);
+        domain[i] = ~(uint64_t)0;
+        if (hasDomains)
+        {
+            const ValueSet &allowed = domains->GetCell(i);
+            if (allowed.Fixed())
+                movable[i] = 0;
+            if (!allowed.Empty())
+            {
+                domain[i] = 0;
+                for (int v = 0; v < numUnits; v++)
+                {
+                    if (allowed.Contains((uint64_t)1 << v))
+                        domain[i] |= (uint64_t)1 << v;
+                }
+            }
+        }
+        rowOf[i] = board.RowForCell(i);
+        colOf[i] = board.ColForCell(i);
+        boxOf[i] = board.BoxForCell(i);
+    }
+
+    boxMovable.clear();
+    boxStart.resize(numUnits + 1);
+    for (int b = 0; b < numUnits; b++)
+    {
+        boxStart[b] = (int)boxMovable.size();
+        for (int k = 0; k < numUnits; k++)
+        {
+            int cell = boxCells[b*numUnits + k];
+            if (movable[cell])
+                boxMovable.push_back(cell);
+        }
+    }
+    boxStart[numUnits] = (int)boxMovable.size();
+}
+
+void SAGrid::Fill(RandomGenerator &gen)
+{
+    // give each box a random permutation of the digits it is missing
+    std::vector<char> used(numUnits);
+    std::vector<int> missing;
+    missing.reserve(numUnits);
+    for (int b = 0; b < numUnits; b++)
+    {
+        // with domains, keep the box's values if the empty cells can be
+        // matched to the missing digits, otherwise refill every movable cell
+        if (hasDomains && (MatchBox(b, true, gen) || MatchBox(b, false, gen)))
+            continue;
+        std::fill(used.begin(), used.end(), 0);
+        for (int k = 0; k < numUnits; k++)
+        {
+            int v = value[boxCells[b*numUnits + k]];
+            if (v >= 0)
+                used[v] = 1;
+        }
+        missing.clear();
+        for (int v = 0; v < numUnits; v++)
+        {
+            if (!used[v])
+                missing.push_back(v);
+        }
+        std::shuffle(missing.begin(), missing.end(), gen);
+
+        size_t next = 0;
+        for (int k = 0; k < numUnits; k++)
+        {
+            int cell = boxCells[b*numUnits + k];
+            if (value[cell] < 0)
+                value[cell] = next < missing.size() ? missing[next++] : 0;
+        }
+    }
+    BuildTables();
+}
+
+bool SAGrid::MatchBox(int box, bool keepValues, RandomGenerator &gen)
+{
+    // random bipartite matching of the box's open cells to its missing
+    // digits, respecting domains. Leaves the box unchanged on failure.
+    std::vector<char> used(numUnits);
+    std::vector<int> cells;
+    for (int k = 0; k < numUnits; k++)
+    {
+        int cell = boxCells[box*numUnits + k];
+        if (value[cell] >= 0 && (keepValues || !movable[cell]))
+            used[value[cell]] = 1;
+        else
+            cells.push_back(cell);
+    }
+    std::shuffle(cells.begin(), cells.end(), gen);
+
+    std::vector<int> owner(numUnits, -1);   // cell holding each digit
+    std::vector<char> visited(numUnits);
+    for (int v = 0; v < numUnits; v++)
+    {
+        if (used[v])
+            owner[v] = -2;
+    }
+    for (size_t k = 0; k < cells.size(); k++)
+    {
+        std::fill(visited.begin(), visited.end(), 0);
+        if (!Augment((int)k, cells, owner, visited, gen))
+            return false;
+    }
+    for (int v = 0; v < numUnits; v++)
+    {
+        if (owner[v] >= 0)
+            value[cells[owner[v]]] = v;
+    }
+    return true;
+}
+
+bool SAGrid::Augment(int k, const std::vector<int> &cells, std::vector<int> &owner, std::vector<char> &visited, RandomGenerator &gen)
+{
+    // Kuhn's augmenting path from cells[k], trying digits from a random start
+    int start = std::uniform_int_distribution<>(0, numUnits-1)(gen);
+    uint64_t allowed = domain[cells[k]];
+    for (int j = 0; j < numUnits; j++)
+    {
+        int v = (start + j) % numUnits;
+        if (!((allowed >> v) & 1) || owner[v] == -2 || visited[v])
+            continue;
+        visited[v] = 1;
+        if (owner[v] < 0 || Augment(owner[v], cells, owner, visited, gen))
+        {
+            owner[v] = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SAGrid::Refill(RandomGenerator &gen)
+{
+    // start again from a fresh random fill of the movable cells
+    for (int i = 0; i < numCells; i++)
+    {
+        if (movable[i])
+            value[i] = -1;
+    }
+    Fill(gen);
+}
+
+void SAGrid::BuildTables()
+{
+    rowCount.assign(numUnits*numUnits, 0);
+    colCount.assign(numUnits*numUnits, 0);
+    rowDup.assign(numUnits, 0);
+    colDup.assign(numUnits, 0);
+    cost = 0;
+    for (int i = 0; i < numCells; i++)
+    {
+        if (rowCount[rowOf[i]*numUnits + value[i]]++ > 0)
+        {
+            rowDup[rowOf[i]]++;
+            cost++;
+        }
+        if (colCount[colOf[i]*numUnits + value[i]]++ > 0)
+        {
+            colDup[colOf[i]]++;
+            cost++;
+        }
+    }
+    conflicted.clear();
+    conflictPos.assign(numCells, -1);
+    for (int i = 0; i < numCells; i++)
+        UpdateConflicted(i);
+}
+
+void SAGrid::WriteTo(Board &board) const
+{
+    // every cell ends up fixed, so propagating each write to its
+    // neighbours would only cost time (seconds on 64x64)
+    for (int i = 0; i < numCells; i++)
+    {
+        const ValueSet &cell = board.GetCell(i);
+        if (!cell.Fixed() || cell.Index() != value[i])
+            board.SetCellUnpropagated(i, ValueSet(numUnits, (uint64_t)1 << value[i]));
+    }
+}
+
+int SAGrid::SwapDelta(int a, int b) const
+{
+    // change in cost from swapping the values of two cells in the same box
+    int va = value[a], vb = value[b];
+    if (va == vb)
+        return 0;
+    int delta = 0;
+    int ra = rowOf[a]*numUnits, rb = rowOf[b]*numUnits;
+    if (ra != rb)
+    {
+        delta += (rowCount[ra + vb] > 0) - (rowCount[ra + va] > 1);
+        delta += (rowCount[rb + va] > 0) - (rowCount[rb + vb] > 1);
+    }
+    int ca = colOf[a]*numUnits, cb = colOf[b]*numUnits;
+    if (ca != cb)
+    {
+        delta += (colCount[ca + vb] > 0) - (colCount[ca + va] > 1);
+        delta += (colCount[cb + va] > 0) - (colCount[cb + vb] > 1);
+    }
+    return delta;
+}
+
+void SAGrid::Move(std::vector<int> &count, std::vector<int> &dup, int unit, int from, int to)
+{
+    // one cell of unit changes from digit from to digit to
+    if (count[unit*numUnits + from]-- > 1)
+    {
+        dup[unit]--;
+        cost--;
+    }
+    if (count[unit*numUnits + to]++ > 0)
+    {
+        dup[unit]++;
+        cost++;
+    }
+}
+
+void SAGrid::UpdateConflicted(int cell)
+{
+    bool in = movable[cell] && (rowDup[rowOf[cell]] > 0 || colDup[colOf[cell]] > 0);
+    if (in && conflictPos[cell] < 0)
+    {
+        conflictPos[cell] = (int)conflicted.size();
+        conflicted.push_back(cell);
+    }
+    else if (!in && conflictPos[cell] >= 0)
+    {
+        int last = conflicted.back();
+        conflicted[conflictPos[cell]] = last;
+        conflictPos[last] = conflictPos[cell];
+        conflicted.pop_back();
+        conflictPos[cell] = -1;
+    }
+}
+
+void SAGrid::Swap(int a, int b)
+{
+    int va = value[a], vb = value[b];
+    if (va == vb)
+        return;
+    int units[4] = { rowOf[a], rowOf[b], colOf[a], colOf[b] };
+    bool before[4] = { rowDup[units[0]] > 0, rowDup[units[1]] > 0, colDup[units[2]] > 0, colDup[units[3]] > 0 };
+
+    if (units[0] != units[1])
+    {
+        Move(rowCount, rowDup, units[0], va, vb);
+        Move(rowCount, rowDup, units[1], vb, va);
+    }
+    if (units[2] != units[3])
+    {
+        Move(colCount, colDup, units[2], va, vb);
+        Move(colCount, colDup, units[3], vb, va);
+    }
+    value[a] = vb;
+    value[b] = va;
+
+    // cells only change membership of the conflicted set when a row or
+    // column gains its first duplicate or loses its last one
+    bool after[4] = { rowDup[units[0]] > 0, rowDup[units[1]] > 0, colDup[units[2]] > 0, colDup[units[3]] > 0 };
+    for (int k = 0; k < 4; k++)
+    {
+        if (before[k] == after[k])
+            continue;
+        const int *cells = k < 2 ? &rowCells[units[k]*numUnits] : &colCells[units[k]*numUnits];
+        for (int j = 0; j < numUnits; j++)
+            UpdateConflicted(cells[j]);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "board.h"
+#include <vector>
+#include "random.h"
+
+//
+// Compact working state for the annealer: one int per cell plus per-row and
+// per-column digit counts, so that the cost change of a swap can be found in
+// O(1) and a swap applied by exchanging two values. Each box always holds a
+// permutation of the digits, so only row and column duplicates cost anything.
+//
+// Given the propagated puzzle as domains, cells the puzzle has fixed are
+// frozen like clues, boxes are filled by matching digits to cells whose
+// domain allows them, and CanSwap only allows swaps which keep both cells
+// inside their domains.
+//
+class SAGrid
+{
+public:
+    void Init(const Board &board, const Board *domains = nullptr);
+    void Fill(RandomGenerator &gen);
+    void Refill(RandomGenerator &gen);
+    void WriteTo(Board &board) const;
+    // keep the values of every cell, e.g. of the best grid so far, and go back to them
+    void Save(std::vector<int> &values) const { values = value; }
+    void Restore(const std::vector<int> &values) { value = values; BuildTables(); }
+
+    int Cost() const { return cost; }
+    int SwapDelta(int a, int b) const;
+    void Swap(int a, int b);
+    bool HasDomains() const { return hasDomains; }
+    bool CanSwap(int a, int b) const
+    {
+        return ((domain[a] >> value[b]) & 1) && ((domain[b] >> value[a]) & 1);
+    }
+
+    int Value(int cell) const { return value[cell]; }
+    bool IsMovable(int cell) const { return movable[cell] != 0; }
+    int NumUnits() const { return numUnits; }
+    int CellCount() const { return numCells; }
+    int BoxForCell(int cell) const { return boxOf[cell]; }
+
+    // movable cells in a box
+    int NumBoxMovable(int box) const { return boxStart[box+1] - boxStart[box]; }
+    int BoxMovable(int box, int k) const { return boxMovable[boxStart[box] + k]; }
+
+    // movable cells which are in a row or column with a duplicate
+    int NumConflicted() const { return (int)conflicted.size(); }
+    int Conflicted(int k) const { return conflicted[k]; }
+
+private:
+    int numUnits;
+    int numCells;
+    int cost;
+    bool hasDomains;
+    std::vector<int> value;     // digit in each cell (0..numUnits-1), -1 until filled
+    std::vector<char> movable;  // cells which are not clues
+    std::vector<uint64_t> domain;   // digits each cell may take, as a bitmap
+    std::vector<int> rowOf, colOf, boxOf;
+    std::vector<int> rowCells, colCells, boxCells;  // cells of unit u at [u*numUnits ...]
+    std::vector<int> boxMovable, boxStart;
+    std::vector<int> rowCount, colCount;    // occurrences of digit v in unit u at [u*numUnits + v]
+    std::vector<int> rowDup, colDup;        // duplicates in each unit
+    std::vector<int> conflicted, conflictPos;   // indexed set, conflictPos is -1 if not in it
+
+    void BuildTables();
+    bool MatchBox(int box, bool keepValues, RandomGenerator &gen);
+    bool Augment(int k, const std::vector<int> &cells, std::vector<int> &owner, std::vector<char> &visited, RandomGenerator &gen);
+    void UpdateConflicted(int cell);
+    void Move(std::vector<int> &count, std::vector<int> &dup, int unit, int from, int to);
+};
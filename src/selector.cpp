@@ -0,0 +1,72 @@
+#include "selector.h"
+#include "selectortable.h"
+#include <cstdlib>
+
+PuzzleFeatures ComputeFeatures(const Board &puzzle)
+{
+	PuzzleFeatures f;
+	f.numUnits = puzzle.GetNumUnits();
+	int numCells = puzzle.CellCount();
+	int clues = 0, fixed = 0, open = 0, total = 0;
+	int histogram[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < numCells; i++)
+	{
+		const ValueSet &cell = puzzle.GetCell(i);
+		if (puzzle.IsClue(i))
+			++clues;
+		if (cell.Fixed())
+		{
+			++fixed;
+			continue;
+		}
+		int count = cell.Count();
+		if (count < 2)
+			continue;
+		++open;
+		total += count;
+		histogram[count < 5 ? count - 2 : 3]++;
+	}
+	f.cluePercent = numCells ? 100.0f * clues / numCells : 0.0f;
+	f.fixedPercent = numCells ? 100.0f * fixed / numCells : 0.0f;
+	f.meanCandidates = open ? (float)total / open : 0.0f;
+	for (int k = 0; k < 4; k++)
+		f.candidates[k] = open ? (float)histogram[k] / open : 0.0f;
+	return f;
+}
+
+int NumSelectorRules()
+{
+	return (int)(sizeof(selectorTable) / sizeof(selectorTable[0]));
+}
+
+int SelectRule(const PuzzleFeatures &features)
+{
+	// sizes the table has no rows for use the nearest size it has
+	int numRules = NumSelectorRules();
+	int units = selectorTable[0].numUnits;
+	for (int r = 0; r < numRules; r++)
+	{
+		if (abs(selectorTable[r].numUnits - features.numUnits) < abs(units - features.numUnits))
+			units = selectorTable[r].numUnits;
+	}
+	// rows for a size are in order of clue percentage, the last covering 100
+	int last = 0;
+	for (int r = 0; r < numRules; r++)
+	{
+		if (selectorTable[r].numUnits != units)
+			continue;
+		last = r;
+		if (features.cluePercent <= selectorTable[r].maxCluePercent)
+			return r;
+	}
+	return last;
+}
+
+SolverOptions RuleOptions(int rule, const SolverOptions &base)
+{
+	SolverOptions opt = base;
+	opt.algorithm = selectorTable[rule].algorithm;
+	opt.nAnts = selectorTable[rule].nAnts;
+	opt.saStall = selectorTable[rule].saStall;
+	return opt;
+}
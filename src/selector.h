@@ -0,0 +1,36 @@
+#pragma once
+#include "solveroptions.h"
+#include "board.h"
+
+//
+// Cheap algorithm selection for --alg auto. Features are taken from the
+// puzzle after the initial constraint propagation (what --showinitial
+// prints), and looked up in a small table built offline from our benchmark
+// CSVs by train_selector.py.
+//
+struct PuzzleFeatures
+{
+	int numUnits;
+	float cluePercent;		// givens, as a percentage of cells
+	float fixedPercent;		// cells fixed after propagation
+	float meanCandidates;	// over the open cells
+	float candidates[4];	// share of open cells with 2, 3, 4 and 5 or more candidates
+};
+
+struct SelectorRule
+{
+	int numUnits;
+	int maxCluePercent;
+	int algorithm;
+	int nAnts;
+	int saStall;
+};
+
+PuzzleFeatures ComputeFeatures(const Board &puzzle);
+
+// index of the table rule for the puzzle, always valid
+int SelectRule(const PuzzleFeatures &features);
+int NumSelectorRules();
+
+// base, with the algorithm and parameters of the rule
+SolverOptions RuleOptions(int rule, const SolverOptions &base);
@@ -0,0 +1,38 @@
+#pragma once
+// generated by train_selector.py from:
+//   ablation-nants_15.csv
+//   ablation-nants_5.csv
+//   ablation_raw/ablation-safreq_100.csv
+//   ablation_raw/ablation-safreq_150.csv
+//   ablation_raw/ablation-safreq_200.csv
+//   ablation_raw/ablation-safreq_300.csv
+//   ablation_raw/ablation-safreq_50.csv
+//   ablation_raw/ablation-safreq_500.csv
+//   annealing.csv
+//   backtrack.csv
+//   sudoku_results.csv
+//   tabu.csv
+// rerun it rather than editing this file by hand
+
+// numUnits, maxCluePercent, algorithm, nAnts, saStall
+static const SelectorRule selectorTable[] =
+{
+	{ 6, 95, 0, 10, 100 },
+	{ 6, 100, 1, 10, 100 },
+	{ 9, 15, 0, 5, 100 },
+	{ 9, 95, 0, 10, 100 },
+	{ 9, 100, 1, 10, 100 },
+	{ 12, 40, 0, 5, 100 },
+	{ 12, 95, 0, 10, 100 },
+	{ 12, 100, 1, 10, 100 },
+	{ 16, 40, 0, 5, 100 },
+	{ 16, 45, 0, 10, 200 },
+	{ 16, 95, 0, 10, 100 },
+	{ 16, 100, 1, 10, 100 },
+	{ 25, 0, 1, 10, 100 },
+	{ 25, 30, 4, 10, 100 },
+	{ 25, 35, 0, 10, 200 },
+	{ 25, 40, 0, 15, 100 },
+	{ 25, 95, 0, 10, 100 },
+	{ 25, 100, 1, 10, 100 },
+};
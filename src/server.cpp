@@ -0,0 +1,389 @@
+#include "server.h"
+#include "sudokulib.h"
+#include "puzzleio.h"
+#include "board.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <signal.h>
+#endif
+using namespace std;
+
+#ifdef _WIN32
+
+int RunServer( const string &address, const SolverOptions &opt, int numThreads, int batchSize, float batchWait )
+{
+	cerr << "--serve is not supported on Windows" << endl;
+	return 1;
+}
+
+int RunClient( const string &address, istream &in, ostream &out, float timeout )
+{
+	cerr << "--connect is not supported on Windows" << endl;
+	return -1;
+}
+
+#else
+
+namespace
+{
+	typedef chrono::steady_clock Clock;
+
+	// an open socket, closed once the last request holding it is answered
+	class Connection
+	{
+		int fd;
+		mutex writeMutex;
+		Connection( const Connection & );
+		Connection &operator=( const Connection & );
+	public:
+		explicit Connection( int fd ) : fd(fd) {}
+		~Connection() { close(fd); }
+		int Fd() const { return fd; }
+		void Write( const string &s )
+		{
+			lock_guard<mutex> lock(writeMutex);
+			size_t done = 0;
+			while ( done < s.length() )
+			{
+				ssize_t n = write(fd, s.data() + done, s.length() - done);
+				if ( n <= 0 )
+					return;		// the other end has gone, nobody to tell
+				done += n;
+			}
+		}
+	};
+
+	bool IsPort( const string &address )
+	{
+		return address.length() != 0 && all_of(address.begin(), address.end(), [](char c) { return c >= '0' && c <= '9'; });
+	}
+
+	// socket listening on address, or connected to it; -1 on failure
+	int OpenSocket( const string &address, bool listening )
+	{
+		int fd;
+		int result;
+		if ( IsPort(address) )
+		{
+			fd = socket(AF_INET, SOCK_STREAM, 0);
+			if ( fd < 0 )
+				return -1;
+			sockaddr_in addr;
+			memset(&addr, 0, sizeof(addr));
+			addr.sin_family = AF_INET;
+			addr.sin_port = htons((unsigned short)atoi(address.c_str()));
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			int on = 1;
+			if ( listening )
+			{
+				setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+				result = ::bind(fd, (sockaddr *)&addr, sizeof(addr));
+			}
+			else
+				result = connect(fd, (sockaddr *)&addr, sizeof(addr));
+			// replies are single short lines, so do not hold them back
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+		}
+		else
+		{
+			sockaddr_un addr;
+			memset(&addr, 0, sizeof(addr));
+			if ( address.length() >= sizeof(addr.sun_path) )
+				return -1;
+			fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			if ( fd < 0 )
+				return -1;
+			addr.sun_family = AF_UNIX;
+			strcpy(addr.sun_path, address.c_str());
+			if ( listening )
+			{
+				// a socket file left by an earlier server would stop bind
+				unlink(address.c_str());
+				result = ::bind(fd, (sockaddr *)&addr, sizeof(addr));
+			}
+			else
+				result = connect(fd, (sockaddr *)&addr, sizeof(addr));
+		}
+		if ( result == 0 && listening )
+			result = listen(fd, 64);
+		if ( result != 0 )
+		{
+			close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	struct Request
+	{
+		shared_ptr<Connection> conn;
+		string id;
+		string puzzle;
+		int numUnits;		// 0 if the puzzle is not a supported size
+		Clock::time_point deadline;
+	};
+
+	class SolveServer
+	{
+		SolverOptions opt;
+		int numThreads;
+		int batchSize;
+		float batchWait;
+		SolutionCache *cache;	// shared by all workers
+
+		mutex queueMutex;
+		condition_variable arrived;		// a request was added to pending
+		condition_variable ready;		// requests were added to work
+		deque<Request> pending;			// not yet batched
+		deque<Request> work;			// batched, ordered by board size
+
+		void AddRequest( const shared_ptr<Connection> &conn, const string &line );
+		void Answer( Request &r, vector<SudokuContext *> &contexts );
+	public:
+		SolveServer( const SolverOptions &opt, int numThreads, int batchSize, float batchWait ) :
+			opt(opt), numThreads(max(numThreads, 1)), batchSize(max(batchSize, 1)), batchWait(batchWait), cache(CreateSolutionCache(opt)) {}
+		~SolveServer() { delete cache; }
+		void Read( shared_ptr<Connection> conn );
+		void Dispatch();
+		void Work();
+	};
+
+	void SolveServer::Read( shared_ptr<Connection> conn )
+	{
+		// split what arrives into lines, each a request
+		string buffer;
+		char chunk[4096];
+		for (;;)
+		{
+			ssize_t n = read(conn->Fd(), chunk, sizeof(chunk));
+			if ( n <= 0 )
+				break;
+			buffer.append(chunk, n);
+			size_t start = 0, end;
+			while ( (end = buffer.find('\n', start)) != string::npos )
+			{
+				AddRequest(conn, buffer.substr(start, end - start));
+				start = end + 1;
+			}
+			buffer.erase(0, start);
+		}
+		if ( buffer.length() != 0 )
+			AddRequest(conn, buffer);
+	}
+
+	void SolveServer::AddRequest( const shared_ptr<Connection> &conn, const string &line )
+	{
+		istringstream words(line);
+		Request r;
+		if ( !(words >> r.id) )
+			return;
+		words >> r.puzzle;
+		float timeout = opt.timeOut;
+		float t;
+		if ( words >> t )
+			timeout = t;
+		r.conn = conn;
+		r.deadline = Clock::now() + chrono::duration_cast<Clock::duration>(chrono::duration<float>(timeout));
+		int boxRows, boxCols;
+		// a bad length or character is answered -1 without building a Board
+		if ( !PuzzleGeometry((int)r.puzzle.length(), r.numUnits, boxRows, boxCols) ||
+			!ValidPuzzleChars(r.puzzle.data(), (int)r.puzzle.length(), r.numUnits) )
+			r.numUnits = 0;
+
+		lock_guard<mutex> lock(queueMutex);
+		pending.push_back(move(r));
+		arrived.notify_one();
+	}
+
+	void SolveServer::Dispatch()
+	{
+		unique_lock<mutex> lock(queueMutex);
+		for (;;)
+		{
+			arrived.wait(lock, [&]() { return !pending.empty(); });
+			// let the batch fill for batchWait after its first request
+			Clock::time_point close = Clock::now() + chrono::duration_cast<Clock::duration>(chrono::duration<float>(batchWait));
+			while ( (int)pending.size() < batchSize && arrived.wait_until(lock, close) != cv_status::timeout )
+				;
+			vector<Request> batch;
+			while ( !pending.empty() && (int)batch.size() < batchSize )
+			{
+				batch.push_back(move(pending.front()));
+				pending.pop_front();
+			}
+
+			// order by board size, so a worker taking the next request mostly
+			// finds its context for that size warm. Requests go on the queue one
+			// at a time, so a slow puzzle holds up only the worker solving it
+			stable_sort(batch.begin(), batch.end(), [](const Request &a, const Request &b) { return a.numUnits < b.numUnits; });
+			for ( auto &r : batch )
+				work.push_back(move(r));
+			ready.notify_all();
+		}
+	}
+
+	void SolveServer::Work()
+	{
+		// one solver context per board size, kept for the life of the server
+		vector<SudokuContext *> contexts(65, nullptr);
+		for (;;)
+		{
+			Request r;
+			{
+				unique_lock<mutex> lock(queueMutex);
+				ready.wait(lock, [&]() { return !work.empty(); });
+				r = move(work.front());
+				work.pop_front();
+			}
+			Answer(r, contexts);
+		}
+	}
+
+	void SolveServer::Answer( Request &r, vector<SudokuContext *> &contexts )
+	{
+		ostringstream reply;
+		reply << r.id << ' ';
+		Board board;
+		if ( r.numUnits != 0 )
+			board = Board(r.puzzle.data(), (int)r.puzzle.length());
+		if ( r.numUnits == 0 || board.GetNumUnits() != r.numUnits )
+		{
+			reply << "-1 0 -\n";
+			r.conn->Write(reply.str());
+			return;
+		}
+
+		// what is left of the request's time, none if it waited too long
+		float timeLeft = chrono::duration<float>(r.deadline - Clock::now()).count();
+		bool success = false;
+		float solTime = 0.0f;
+		const Board *result = &board;
+		if ( timeLeft > 0.0f )
+		{
+			SudokuContext *&ctx = contexts[r.numUnits];
+			if ( ctx == nullptr )
+			{
+				ctx = new SudokuContext(r.numUnits, opt);
+				ctx->SetCache(cache);
+			}
+			ctx->SetTimeOut(timeLeft);
+			success = ctx->Solve(board);
+			solTime = ctx->GetSolutionTime();
+			result = &ctx->GetSolution();
+		}
+		reply << (success ? 1 : 0) << ' ' << solTime << ' ';
+		for ( int i = 0; i < result->CellCount(); i++ )
+		{
+			const ValueSet &cell = result->GetCell(i);
+			reply << PuzzleValueChar(cell.Fixed() ? cell.Index() + 1 : 0, r.numUnits);
+		}
+		reply << '\n';
+		r.conn->Write(reply.str());
+	}
+}
+
+int RunServer( const string &address, const SolverOptions &opt, int numThreads, int batchSize, float batchWait )
+{
+	// a client closing early must not end the server
+	signal(SIGPIPE, SIG_IGN);
+	int listener = OpenSocket(address, true);
+	if ( listener < 0 )
+	{
+		cerr << "cannot listen on " << address << endl;
+		return 1;
+	}
+	SolveServer *server = new SolveServer(opt, numThreads, batchSize, batchWait);
+	thread(&SolveServer::Dispatch, server).detach();
+	for ( int t = 0; t < max(numThreads, 1); t++ )
+		thread(&SolveServer::Work, server).detach();
+	for (;;)
+	{
+		int fd = accept(listener, nullptr, nullptr);
+		if ( fd < 0 )
+			continue;
+		if ( IsPort(address) )
+		{
+			int on = 1;
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+		}
+		thread(&SolveServer::Read, server, make_shared<Connection>(fd)).detach();
+	}
+}
+
+int RunClient( const string &address, istream &in, ostream &out, float timeout )
+{
+	signal(SIGPIPE, SIG_IGN);
+	int fd = OpenSocket(address, false);
+	if ( fd < 0 )
+	{
+		cerr << "cannot connect to " << address << endl;
+		return -1;
+	}
+	Connection conn(fd);
+
+	// send from another thread, so replies are read while puzzles still go out
+	thread sender([&]()
+	{
+		string line;
+		int id = 0;
+		while ( getline(in, line) )
+		{
+			istringstream words(line);
+			string puzzle;
+			if ( !(words >> puzzle) || puzzle[0] == '#' )
+				continue;
+			ostringstream request;
+			request << ++id << ' ' << puzzle;
+			if ( timeout > 0.0f )
+				request << ' ' << timeout;
+			request << '\n';
+			conn.Write(request.str());
+		}
+		// the server answers what it has, then closes the connection
+		shutdown(fd, SHUT_WR);
+	});
+
+	int numFailed = 0;
+	string buffer;
+	char chunk[4096];
+	ssize_t n;
+	while ( (n = read(fd, chunk, sizeof(chunk))) > 0 )
+	{
+		buffer.append(chunk, n);
+		size_t start = 0, end;
+		while ( (end = buffer.find('\n', start)) != string::npos )
+		{
+			string reply = buffer.substr(start, end - start);
+			istringstream words(reply);
+			string id;
+			int success = 0;
+			words >> id >> success;
+			if ( success != 1 )
+				++numFailed;
+			out << reply << '\n';
+			start = end + 1;
+		}
+		buffer.erase(0, start);
+		out.flush();
+	}
+	sender.join();
+	return numFailed;
+}
+
+#endif
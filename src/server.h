@@ -0,0 +1,35 @@
+#pragma once
+#include "solveroptions.h"
+#include <string>
+#include <istream>
+#include <ostream>
+
+//
+// Solve service, so that a caller need not start a process per puzzle.
+// The server listens on address: a TCP port on localhost if it is a number,
+// otherwise the path of a Unix domain socket. Each connection sends one
+// request per line,
+//   id puzzle [timeout]
+// with the puzzle in the --puzzle string format and the timeout in seconds
+// (opt.timeOut if not given). The deadline runs from when the request
+// arrives, so time spent queued counts against it; a request still queued
+// at its deadline fails without being solved. Replies go back on the same
+// connection as each solve finishes, so not necessarily in request order:
+//   id success time solution
+// with success 1 if solved, 0 if not (the solution then has '.' for cells
+// left unset) and -1 if the puzzle could not be read, with solution "-".
+//
+// Requests arriving within batchWait seconds of each other, up to
+// batchSize, are taken together and ordered by board size; each of
+// numThreads workers takes the next one whenever it is free. Each worker keeps one solver context per board
+// size for as long as the server runs, so pheromone and board buffers are
+// reused from one request to the next.
+//
+// RunServer returns only if the address cannot be opened (returning 1).
+int RunServer( const std::string &address, const SolverOptions &opt, int numThreads, int batchSize, float batchWait );
+
+// Client for testing: sends each puzzle line of in (blank lines and lines
+// starting with '#' skipped), numbered from 1, with timeout if it is
+// positive, and writes the replies to out as they come. Returns the number
+// of puzzles not solved, or -1 if it cannot connect.
+int RunClient( const std::string &address, std::istream &in, std::ostream &out, float timeout );
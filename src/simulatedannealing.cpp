@@ -1,466 +1,402 @@
 #include "simulatedannealing.h"
 #include "board.h"
-#include <unordered_set>
+#include <algorithm>
 #include <random>
 #include <cmath>
 #include <iostream>
-#include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <climits>
 
-int SudokuSA::Anneal()
+namespace
 {
-    FillEmptyCells();
-    // cout << "\n" << sol.AsString(true);
-    double coolingRate = 0.995;
-    double stoppingTemp = 0.01;
-    double temp = 1.5;
-    int currentCost = ComputeCost();
-    int worst = 0;
-    int moves = 0;
-    int cycles = 0;
-
-    // cout << to_string(currentCost) + "\n";
-
-    if (currentCost == 0){
-        return currentCost;
-    }
-    
-    
-    bestSol.Copy(sol);
-    bestCost = currentCost;
-
-    // cout << "\nFrom " + to_string(bestCost) + " to ";
-    
-
-    while(temp > stoppingTemp){
-        for (int i = 0; i < 1; i++){
-            int origCost = currentCost;
-            currentSol.Copy(sol);
-            
-            int newCost = TryRandomSwap(origCost);
-            int delta = newCost - currentCost;
-            if(delta <= 0){
-                moves = moves+1;
-                currentCost = newCost;
-                if (currentCost < bestCost){
-                    bestSol.Copy(sol);
-                    bestCost = currentCost;
-                    if (currentCost == 0){
-                        // cout << "\n" << sol.AsString(true);
-                        return 0;
-                    }
-                }
-                
-            }
-            else{
-                acceptanceProbability = exp(-delta / temp);
-                double rnd = (double) rand() / RAND_MAX;
-                if (rnd < acceptanceProbability){
-                    moves = moves+1;
-                    currentCost = newCost;
-                }
-                else{
-                    sol.Copy(currentSol);
-                }
+    // all threads wait in Wait() until the last one arrives
+    class Barrier
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        int numThreads;
+        int waiting;
+        int generation;
+    public:
+        Barrier(int numThreads) : numThreads(numThreads), waiting(0), generation(0) {}
+        void Wait()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            int gen = generation;
+            if (++waiting == numThreads)
+            {
+                waiting = 0;
+                ++generation;
+                cv.notify_all();
             }
-            
-            // cout << "Temperature = " + to_string(temp) + "; "+ to_string(origCost) + " to " + to_string(currentCost);
-            if (currentCost > worst)
-                worst = currentCost;
-        }
-        
-        cycles = cycles+1;
-        temp = temp* coolingRate;
-        if (temp < stoppingTemp){
-            // cout <<to_string(currentCost) + " Worst: " + to_string(worst) + " Moves: " + to_string(moves) + " Cycles: " + to_string(cycles) +".\n ";
+            else
+                cv.wait(lock, [this, gen] { return gen != generation; });
         }
-        
-        
-    }
+    };
+}
 
-    
-  
+SudokuSA::SudokuSA(int numReplicas)
+{
+    InitSchedule(numReplicas);
+}
 
-    // for (int i = 0; i < 100; i++){
-    //     string origCost =  to_string(ComputeCost());
-    //     cout << origCost + " to " + to_string(TryRandomSwap());
-        
-    // }
-    //cout << "\n" << sol.AsString(true);
-    //cout << "\n******************\n";
+SudokuSA::SudokuSA(Board sol, int numReplicas) : sol(sol)
+{
+    InitSchedule(numReplicas);
+}
 
-    // abort();
-    CleanDuplicates();
-    return bestCost;
-    
+void SudokuSA::InitSchedule(int numReplicas)
+{
+    chains.resize(numReplicas < 1 ? 1 : numReplicas);
+    seeded = false;     // seeded at the first fill, unless SetSeed comes first
+    // one short pass, as used to polish the ant system's best solution
+    initTemp = 1.5;
+    coolingRate = 0.995;
+    stopTemp = 0.01;
+    reheatMoves = 0;
+    useDomains = false;
+    solTime = 0.0f;
+    movesPerSec = 0.0f;
 }
 
-int SudokuSA::ComputeCost()
+void SudokuSA::SetSeed(unsigned int seed)
 {
-    int cost = 0;
-    int numUnits = sol.GetNumUnits();
-    int numCells = sol.CellCount();
+    for (size_t k = 0; k < chains.size(); k++)
+        chains[k].gen.seed(DeriveSeed(seed, (uint32_t)k));
+    seeded = true;
+}
 
-    // --- Empty cell cost ---
-    for (int i = 0; i < numCells; i++)
-    {
-        const ValueSet& cell = sol.GetCell(i);
-        if (!cell.Fixed())
-            cost += 1; // empty cell adds cost
-    }
+void SudokuSA::SetSchedule(double initTemp, double coolingRate, double stopTemp, int reheatMoves)
+{
+    this->initTemp = initTemp;
+    this->coolingRate = coolingRate;
+    this->stopTemp = stopTemp;
+    this->reheatMoves = reheatMoves;
+}
 
-    // --- Row duplicate cost ---
-    for (int row = 0; row < numUnits; row++)
-    {
-        std::unordered_set<int> seen;
-        for (int col = 0; col < numUnits; col++)
-        {
-            const ValueSet& cell = sol.GetCell(sol.RowCell(row, col));
-            if (cell.Fixed())
-            {
-                int val = cell.Index();
-                if (seen.count(val))
-                    cost += 1; // duplicate value in row
-                else
-                    seen.insert(val);
-            }
-        }
+void SudokuSA::SetDomains(const Board &puzzle)
+{
+    domains.Copy(puzzle);
+    useDomains = true;
+}
+
+bool SudokuSA::Solve(const Board& puzzle, float maxTime)
+{
+    if (useDomains)
+        SetDomains(puzzle);
+    sol.Copy(puzzle);
+    int cost = Anneal(maxTime);
+    solTime = solutionTimer.Elapsed();
+    return cost == 0;
+}
+
+void SAChain::Step()
+{
+    // one Metropolis move. Moves are evaluated before they are made, so a
+    // rejected move needs no undo.
+    int idx1, idx2;
+    ++moves;
+    if (!PickRandomSwap(idx1, idx2))
+        return;
+    int delta = grid.SwapDelta(idx1, idx2);
+    bool accept = delta <= 0;
+    if (!accept){
+        std::uniform_real_distribution<double> rnd(0.0, 1.0);
+        accept = rnd(gen) < exp(-delta / temp);
+    }
+    if (accept){
+        grid.Swap(idx1, idx2);
+        if (grid.Cost() < bestCost)
+            bestCost = grid.Cost();
     }
+}
 
-    // --- Column duplicate cost ---
-    for (int col = 0; col < numUnits; col++)
-    {
-        std::unordered_set<int> seen;
-        for (int row = 0; row < numUnits; row++)
-        {
-            const ValueSet& cell = sol.GetCell(sol.ColCell(col, row));
-            if (cell.Fixed())
-            {
-                int val = cell.Index();
-                if (seen.count(val))
-                    cost += 1; // duplicate value in column
-                else
-                    seen.insert(val);
-            }
+bool SAChain::PickRandomSwap(int &idx1, int &idx2)
+{
+    // pick a non-clue cell in a row or column with a duplicate, and a
+    // non-clue partner in the same box
+    if (grid.NumConflicted() == 0)
+        return false;
+
+    std::uniform_int_distribution<> d1(0, grid.NumConflicted()-1);
+    idx1 = grid.Conflicted(d1(gen));
+
+    int box = grid.BoxForCell(idx1);
+    int numSame = grid.NumBoxMovable(box) - 1;
+    if (numSame <= 0)
+        return false;
+
+    if (grid.HasDomains()){
+        // choose among the partners whose values each cell's domain allows
+        int valid[64];
+        int numValid = 0;
+        for (int k = 0; k <= numSame; k++){
+            int cell = grid.BoxMovable(box, k);
+            if (cell != idx1 && grid.CanSwap(idx1, cell))
+                valid[numValid++] = cell;
         }
+        if (numValid == 0)
+            return false;
+        std::uniform_int_distribution<> d(0, numValid-1);
+        idx2 = valid[d(gen)];
+        return true;
     }
 
-    return cost;
+    // choose among the other movable cells in the box
+    std::uniform_int_distribution<> d2(0, numSame-1);
+    int k = d2(gen);
+    idx2 = grid.BoxMovable(box, k);
+    if (idx2 == idx1)
+        idx2 = grid.BoxMovable(box, numSame);
+    return true;
 }
 
-void SudokuSA::FillEmptyCells()
+int SudokuSA::Anneal(float maxTime)
 {
-    int numCells = sol.CellCount();
-    int numUnits = sol.GetNumUnits();      // e.g., 16 for 16x16
-    int blockSize = numUnits;              // number of cells per block
-    int numBlocks = numCells / blockSize;  // total number of blocks
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
-
-    // For each block
-    for (int block = 0; block < numBlocks; block++)
-    {
-        // Track which numbers are already present in fixed cells of this block
-        std::vector<bool> used(numUnits, false);
-        std::vector<int> emptyCells; // store indices of non-fixed cells
+    // one move per temperature step. With reheating on, the temperature goes
+    // back to initTemp whenever reheatMoves pass without a new best or it
+    // reaches stopTemp, and only solving or maxTime ends the run.
+    const int timerCheckInterval = 1024;
+    solutionTimer.Reset();
+    trace.clear();
+    FillEmptyCells();
 
-        // Scan the block
-        for (int pos = 0; pos < numUnits; pos++)
-        {
-            int cellIndex = sol.BoxCell(block, pos);
-            if (!sol.IsEmpty(cellIndex))
-            {
-                
-                int val = sol.GetCell(cellIndex).Index();
-                if (val >= 0 && val < numUnits)
-                    used[val] = true;
+    if (chains.size() > 1){
+        int numSteps = 0;
+        if (reheatMoves <= 0)
+            numSteps = (int)ceil(log(stopTemp / initTemp) / log(coolingRate));
+        bestCost = AnnealParallel(initTemp, stopTemp, numSteps, maxTime);
+    }
+    else{
+        SAChain &chain = chains[0];
+        chain.bestCost = chain.grid.Cost();
+        bestCost = chain.bestCost;
+        std::vector<int> bestValues;    // best grid so far, returned if time runs out
+        chain.grid.Save(bestValues);
+        RecordImprovement(solutionTimer.Elapsed(), chain.grid.CellCount(), bestCost);
+
+        double temp = initTemp;
+        long long lastImprovement = 0;
+        while (bestCost > 0){
+            if (temp <= stopTemp || (reheatMoves > 0 && chain.moves - lastImprovement >= reheatMoves)){
+                if (reheatMoves <= 0)
+                    break;
+                temp = initTemp;
+                // the domain-restricted neighbourhood is not connected, so
+                // reheating alone can leave the chain stuck in its region
+                if (chain.grid.HasDomains())
+                    chain.grid.Refill(chain.gen);
+                chain.bestCost = chain.grid.Cost();
+                lastImprovement = chain.moves;
             }
-            else
-            {
-                emptyCells.push_back(cellIndex);
+            chain.temp = temp;
+            int prevBest = chain.bestCost;
+            chain.Step();
+            if (chain.bestCost < prevBest)
+                lastImprovement = chain.moves;
+            if (chain.bestCost < bestCost){
+                bestCost = chain.bestCost;
+                chain.grid.Save(bestValues);
+                RecordImprovement(solutionTimer.Elapsed(), chain.grid.CellCount(), bestCost);
             }
-        }
-
-        // Build missing numbers for this block
-        std::vector<int> missing;
-        missing.reserve(emptyCells.size());
-        for (int n = 0; n < numUnits; n++)
-        {
-            if (!used[n])
-                missing.push_back(n);
-        }
-
-        // Shuffle missing numbers
-        std::shuffle(missing.begin(), missing.end(), gen);
+            temp = temp* coolingRate;
 
-        // Fill only empty (non-fixed) cells
-        for (size_t i = 0; i < emptyCells.size(); i++)
-        {
-            int cellIndex = emptyCells[i];
-            int value = missing[i];
-            sol.ForceSetCell(cellIndex, ValueSet(numUnits, (int64_t)1 << value));
+            if (StopRequested() || ((chain.moves % timerCheckInterval) == 0 && TimeUp(maxTime)))
+                break;
         }
+        if (chain.grid.Cost() > bestCost)
+            chain.grid.Restore(bestValues);
+        chain.grid.WriteTo(sol);
+        bestCost = chain.grid.Cost();
+        if (bestCost != 0)
+            CleanDuplicates();
     }
-}
-
-
 
+    long long totalMoves = 0;
+    for (auto &c : chains)
+        totalMoves += c.moves;
+    float elapsed = solutionTimer.Elapsed();
+    movesPerSec = elapsed > 0.0f ? (float)(totalMoves / elapsed) : 0.0f;
+    return bestCost;
+}
 
-int SudokuSA::TryRandomSwap(int oldCost)
+int SudokuSA::AnnealParallel(double maxTemp, double minTemp, int numSteps, float maxTime)
 {
-    int numUnits = sol.GetNumUnits();
-
-    // Identify conflict cells same as before
-    std::vector<int> conflictedCells;
-    conflictedCells.reserve(sol.CellCount());
-
-    std::vector<bool> rowHasDup(numUnits, false);
-    std::vector<bool> colHasDup(numUnits, false);
-
-    // Detect conflict rows
-    for (int row = 0; row < numUnits; ++row)
-    {
-        std::unordered_set<int> seen;
-        bool dup = false;
-        for (int c = 0; c < numUnits; ++c)
-        {
-            int idx = sol.RowCell(row,c);
-            if (!sol.GetCell(idx).Fixed()) continue;
-            int v = sol.GetCell(idx).Index();
-            if (!seen.insert(v).second) { dup = true; break; }
-        }
-        rowHasDup[row] = dup;
+    // Parallel tempering: one chain per thread, each at a fixed temperature
+    // on a geometric ladder from minTemp to maxTemp. Every exchangeInterval
+    // moves, neighbouring temperatures swap their grids with the usual
+    // replica exchange acceptance. Each chain makes numSteps moves in all,
+    // or keeps going until solved or out of time if numSteps is 0.
+    const int exchangeInterval = 100;
+    int numChains = (int)chains.size();
+    for (int r = 0; r < numChains; r++){
+        chains[r].temp = minTemp * pow(maxTemp / minTemp, r / (double)(numChains - 1));
+        chains[r].bestCost = chains[r].grid.Cost();
     }
 
-    // Detect conflict columns
-    for (int col = 0; col < numUnits; ++col)
-    {
-        std::unordered_set<int> seen;
-        bool dup = false;
-        for (int r = 0; r < numUnits; ++r)
-        {
-            int idx = sol.ColCell(col,r);
-            if (!sol.GetCell(idx).Fixed()) continue;
-            int v = sol.GetCell(idx).Index();
-            if (!seen.insert(v).second) { dup = true; break; }
+    std::atomic<bool> solved(false);
+    for (auto &c : chains)
+        if (c.grid.Cost() == 0)
+            solved = true;
+
+    int numRounds = numSteps > 0 ? (numSteps + exchangeInterval - 1) / exchangeInterval : INT_MAX;
+    RandomGenerator exchangeGen(chains[0].gen());
+    Barrier barrier(numChains);
+    // stop is only written between the two barriers of a round, and only
+    // read outside them, so all threads agree on whether to go on
+    bool stop = solved;
+    int traceBest = INT_MAX;
+    auto run = [&](int r) {
+        SAChain &chain = chains[r];
+        for (int round = 0; round < numRounds && !stop; round++){
+            for (int m = 0; m < exchangeInterval && !solved; m++){
+                chain.Step();
+                if (chain.grid.Cost() == 0)
+                    solved = true;
+            }
+            barrier.Wait();
+            if (r == 0){
+                int cost = chains[0].grid.Cost();
+                for (auto &c : chains)
+                    cost = std::min(cost, c.grid.Cost());
+                if (cost < traceBest){
+                    traceBest = cost;
+                    RecordImprovement(solutionTimer.Elapsed(), chains[0].grid.CellCount(), cost);
+                }
+                stop = solved || TimeUp(maxTime);
+                if (!stop)
+                    ExchangeReplicas(round, exchangeGen);
+            }
+            barrier.Wait();
         }
-        colHasDup[col] = dup;
-    }
+    };
+    std::vector<std::thread> threads;
+    for (int r = 1; r < numChains; r++)
+        threads.push_back(std::thread(run, r));
+    run(0);
+    for (auto &t : threads)
+        t.join();
+
+    // keep the lowest-cost grid
+    int best = 0;
+    for (int r = 1; r < numChains; r++)
+        if (chains[r].grid.Cost() < chains[best].grid.Cost())
+            best = r;
+    bestCost = chains[best].grid.Cost();
+    chains[best].grid.WriteTo(sol);
+    if (bestCost != 0)
+        CleanDuplicates();
+    return bestCost;
+}
 
-    // Collect swap candidates
-    for (int idx = 0; idx < sol.CellCount(); ++idx)
-    {
-        if (sol.IsClue(idx)) continue;
-        if (rowHasDup[sol.RowForCell(idx)] ||
-            colHasDup[sol.ColForCell(idx)])
-        {
-            conflictedCells.push_back(idx);
+void SudokuSA::ExchangeReplicas(int round, RandomGenerator &gen)
+{
+    // alternate between even and odd neighbouring pairs
+    std::uniform_real_distribution<double> rnd(0.0, 1.0);
+    for (size_t r = round % 2; r + 1 < chains.size(); r += 2){
+        SAChain &cold = chains[r], &hot = chains[r+1];
+        double x = (cold.grid.Cost() - hot.grid.Cost()) * (1.0 / cold.temp - 1.0 / hot.temp);
+        if (x >= 0.0 || rnd(gen) < exp(x)){
+            std::swap(cold.grid, hot.grid);
+            std::swap(cold.bestCost, hot.bestCost);
         }
     }
+}
 
-    if (conflictedCells.empty())
-        return oldCost;
-
-    static std::mt19937 gen(std::random_device{}());
-    std::uniform_int_distribution<> d1(0, conflictedCells.size()-1);
-
-    int idx1 = conflictedCells[d1(gen)];
-    int box = sol.BoxForCell(idx1);
-
-    // Pick partner in same box
-    std::vector<int> same;
-    for (int pos = 0; pos < numUnits; ++pos)
-    {
-        int idx = sol.BoxCell(box,pos);
-        if (!sol.IsClue(idx) && idx!=idx1)
-            same.push_back(idx);
+void SudokuSA::FillEmptyCells()
+{
+    // fill each chain's working grid - each box gets a random permutation
+    // of the values it is missing. sol is only written back at the end of
+    // Anneal.
+    if (!seeded)
+        SetSeed(RandomSeed());
+    for (auto &c : chains){
+        c.grid.Init(sol, useDomains ? &domains : nullptr);
+        c.grid.Fill(c.gen);
+        c.moves = 0;
     }
-    if (same.empty())
-        return oldCost;
-
-    std::uniform_int_distribution<> d2(0, same.size()-1);
-    int idx2 = same[d2(gen)];
-
-    // Compute local conflicts BEFORE swap
-    int before =
-        LocalConflicts(idx1) +
-        LocalConflicts(idx2);
-
-    // Swap
-    ValueSet v1 = sol.GetCell(idx1);
-    ValueSet v2 = sol.GetCell(idx2);
-    sol.ForceSetCell(idx1,v2);
-    sol.ForceSetCell(idx2,v1);
-
-    // Compute local conflicts AFTER swap
-    int after =
-        LocalConflicts(idx1) +
-        LocalConflicts(idx2);
-
-    return oldCost + (after - before);
 }
 
-int SudokuSA::LocalConflicts(int idx)
+ValueSet SudokuSA::RepeatedValues(bool rows, int unit)
 {
+    // set of the values held by more than one fixed cell in a row or column
     int numUnits = sol.GetNumUnits();
-    int row = sol.RowForCell(idx);
-    int col = sol.ColForCell(idx);
-    int val = sol.GetCell(idx).Index();
-    int conflicts = 0;
-
-    // Check row duplicates
-    for(int c = 0; c < numUnits; c++){
-        int id = sol.RowCell(row,c);
-        if(id != idx && sol.GetCell(id).Fixed()){
-            if(sol.GetCell(id).Index() == val)
-                conflicts++;
-        }
-    }
-
-    // Check column duplicates
-    for(int r = 0; r < numUnits; r++){
-        int id = sol.ColCell(col,r);
-        if(id != idx && sol.GetCell(id).Fixed()){
-            if(sol.GetCell(id).Index() == val)
-                conflicts++;
+    ValueSet seen(numUnits), repeated(numUnits);
+    for (int k = 0; k < numUnits; k++)
+    {
+        const ValueSet& cell = sol.GetCell(rows ? sol.RowCell(unit, k) : sol.ColCell(unit, k));
+        if (cell.Fixed())
+        {
+            if (seen.Contains(cell))
+                repeated += cell;
+            seen += cell;
         }
     }
-
-    return conflicts;
+    return repeated;
 }
 
-
-void SudokuSA::CleanDuplicates()
+void SudokuSA::RemoveWorstDuplicates(bool rows, const std::vector<int> &conflictCount)
 {
+    // in each row (or column), empty the cell with the highest conflict
+    // count among those sharing each repeated value - the first such
+    // cell in the unit on a tie
     int numUnits = sol.GetNumUnits();
-    int numCells = sol.CellCount();
+    std::vector<int> worstIdx(numUnits);
 
-    // conflictCount[i] = number of duplicate conflicts the cell participates in
-    std::vector<int> conflictCount(numCells, 0);
-
-    // --- Count conflicts in rows ---
-    for (int row = 0; row < numUnits; row++)
+    for (int unit = 0; unit < numUnits; unit++)
     {
-        std::unordered_map<int, std::vector<int>> positions;
+        ValueSet repeated = RepeatedValues(rows, unit);
+        if (repeated.Empty())
+            continue;
 
-        for (int col = 0; col < numUnits; col++)
+        std::fill(worstIdx.begin(), worstIdx.end(), -1);
+        for (int k = 0; k < numUnits; k++)
         {
-            int idx = sol.RowCell(row, col);
+            int idx = rows ? sol.RowCell(unit, k) : sol.ColCell(unit, k);
             const ValueSet& cell = sol.GetCell(idx);
-
-            if (cell.Fixed())
-                positions[cell.Index()].push_back(idx);
+            if (!cell.Fixed() || !repeated.Contains(cell))
+                continue;
+            int &worst = worstIdx[cell.Index()];
+            if (worst == -1 || conflictCount[idx] > conflictCount[worst])
+                worst = idx;
         }
-
-        // Any number with >1 occurrences is a duplicate
-        for (auto& p : positions)
+        for (int v = 0; v < numUnits; v++)
         {
-            if (p.second.size() > 1)
-            {
-                for (int idx : p.second)
-                    conflictCount[idx]++;
-            }
+            if (worstIdx[v] != -1)
+                sol.ForceSetCell(worstIdx[v], ValueSet(numUnits, 0));
         }
     }
+}
 
-    // --- Count conflicts in columns ---
-    for (int col = 0; col < numUnits; col++)
-    {
-        std::unordered_map<int, std::vector<int>> positions;
-
-        for (int row = 0; row < numUnits; row++)
-        {
-            int idx = sol.ColCell(col, row);
-            const ValueSet& cell = sol.GetCell(idx);
-
-            if (cell.Fixed())
-                positions[cell.Index()].push_back(idx);
-        }
-
-        // duplicates → increment conflict counts
-        for (auto& p : positions)
-        {
-            if (p.second.size() > 1)
-            {
-                for (int idx : p.second)
-                    conflictCount[idx]++;
-            }
-        }
-    }
+void SudokuSA::CleanDuplicates()
+{
+    int numUnits = sol.GetNumUnits();
+    int numCells = sol.CellCount();
 
-    // --- Now remove one cell among duplicates (the worst one) ---
+    // conflictCount[i] = number of rows and columns in which cell i shares
+    // its value with another cell
+    std::vector<int> conflictCount(numCells, 0);
 
-    // Rows first
-    for (int row = 0; row < numUnits; row++)
+    for (int unit = 0; unit < numUnits; unit++)
     {
-        std::unordered_map<int, std::vector<int>> positions;
-
-        for (int col = 0; col < numUnits; col++)
-        {
-            int idx = sol.RowCell(row, col);
-            const ValueSet& cell = sol.GetCell(idx);
-
-            if (cell.Fixed())
-                positions[cell.Index()].push_back(idx);
-        }
-
-        for (auto& p : positions)
+        ValueSet rowRepeated = RepeatedValues(true, unit);
+        ValueSet colRepeated = RepeatedValues(false, unit);
+        for (int k = 0; k < numUnits; k++)
         {
-            auto& duplicates = p.second;
-            if (duplicates.size() <= 1)
-                continue;
-
-            // Pick the duplicate with highest conflict count
-            int worstIdx = duplicates[0];
-            int worstScore = conflictCount[worstIdx];
-
-            for (int idx : duplicates)
-            {
-                if (conflictCount[idx] > worstScore)
-                {
-                    worstIdx = idx;
-                    worstScore = conflictCount[idx];
-                }
-            }
-
-            // Remove the worst duplicate (only one removed)
-            sol.ForceSetCell(worstIdx, ValueSet(numUnits, 0));
+            int idx = sol.RowCell(unit, k);
+            if (sol.GetCell(idx).Fixed() && rowRepeated.Contains(sol.GetCell(idx)))
+                conflictCount[idx]++;
+            idx = sol.ColCell(unit, k);
+            if (sol.GetCell(idx).Fixed() && colRepeated.Contains(sol.GetCell(idx)))
+                conflictCount[idx]++;
         }
     }
 
-    // Columns next
-    for (int col = 0; col < numUnits; col++)
-    {
-        std::unordered_map<int, std::vector<int>> positions;
-
-        for (int row = 0; row < numUnits; row++)
-        {
-            int idx = sol.ColCell(col, row);
-            const ValueSet& cell = sol.GetCell(idx);
-
-            if (cell.Fixed())
-                positions[cell.Index()].push_back(idx);
-        }
-
-        for (auto& p : positions)
-        {
-            auto& duplicates = p.second;
-            if (duplicates.size() <= 1)
-                continue;
-
-            int worstIdx = duplicates[0];
-            int worstScore = conflictCount[worstIdx];
-
-            for (int idx : duplicates)
-            {
-                if (conflictCount[idx] > worstScore)
-                {
-                    worstIdx = idx;
-                    worstScore = conflictCount[idx];
-                }
-            }
-
-            sol.ForceSetCell(worstIdx, ValueSet(numUnits, 0));
-        }
-    }
+    // remove one cell among each set of duplicates, rows first, then
+    // columns of what is left
+    RemoveWorstDuplicates(true, conflictCount);
+    RemoveWorstDuplicates(false, conflictCount);
 }
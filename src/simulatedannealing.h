@@ -1,23 +1,71 @@
 #pragma once
 #include "board.h"
+#include "sagrid.h"
+#include "sudokusolver.h"
+#include "timer.h"
+#include "random.h"
+#include <vector>
+#include <atomic>
 
-class SudokuSA
+// one annealing chain: its own working grid, random numbers and temperature
+class SAChain
+{
+public:
+    SAGrid grid;
+    RandomGenerator gen;
+    double temp;
+    int bestCost;
+    long long moves;
+
+    void Step();
+private:
+    bool PickRandomSwap(int &idx1, int &idx2);
+};
+
+//
+// Simulated annealing over box permutations. Used by the ant system to
+// refine its best solution with one pass of the schedule, or on its own as a
+// solver (--alg 3), when it reheats whenever it stalls and keeps going until
+// it solves the puzzle or runs out of time.
+//
+class SudokuSA : public SudokuSolver
 {
 	Board sol;	// current working solution
-    Board bestSol;
-    Board currentSol;
+    std::vector<SAChain> chains;    // one per replica, chains[0] for a single chain
+    bool seeded;            // chains seeded, by SetSeed or from random_device
     int bestCost;
-    double acceptanceProbability;
+    double initTemp;
+    double coolingRate;     // per move
+    double stopTemp;
+    int reheatMoves;        // moves without a new best before reheating, 0 to never reheat
+    bool useDomains;        // restrict moves to the propagated puzzle's candidates
+    Board domains;
+    Timer solutionTimer;
+    float solTime;
+    float movesPerSec;
 
 public:	
-	SudokuSA(Board sol): sol(sol) {}
-    int Anneal();
-    int ComputeCost();
+    SudokuSA(int numReplicas = 1);
+	SudokuSA(Board sol, int numReplicas = 1);
+    void SetSchedule(double initTemp, double coolingRate, double stopTemp, int reheatMoves);
+    void SetUseDomains(bool use) { useDomains = use; }
+    void SetDomains(const Board &puzzle);
+    int Anneal(float maxTime);
     void FillEmptyCells();
-    Board GetSolution(){return sol;}
+
+    virtual bool Solve(const Board& puzzle, float maxTime);
+    virtual float GetSolutionTime() { return solTime; }
+    virtual int GetCycles() { return (int)movesPerSec; }
+    virtual const Board& GetSolution() { return sol; }
+    // chain k draws from stream k of the seed
+    virtual void SetSeed(unsigned int seed);
 private:
-    int TryRandomSwap(int oldCost);
+    void InitSchedule(int numReplicas);
+    bool TimeUp(float maxTime) { return StopRequested() || solutionTimer.Elapsed() > maxTime; }
+    int AnnealParallel(double maxTemp, double minTemp, int numSteps, float maxTime);
+    void ExchangeReplicas(int round, RandomGenerator &gen);
     void CleanDuplicates();
-    int LocalConflicts(int idx);
+    ValueSet RepeatedValues(bool rows, int unit);
+    void RemoveWorstDuplicates(bool rows, const std::vector<int> &conflictCount);
     
 }; 
@@ -0,0 +1,76 @@
+#include "solutioncache.h"
+#include <sstream>
+using namespace std;
+
+SolutionCache::SolutionCache( int capacity, const string &fileName ) : capacity(capacity), hits(0), misses(0)
+{
+	if ( fileName.length() == 0 )
+		return;
+	// later lines are newer, so they end up most recently used
+	ifstream in(fileName.c_str());
+	string line;
+	while ( getline(in, line) )
+	{
+		istringstream words(line);
+		string givens, solution;
+		if ( words >> givens >> solution && givens.length() == solution.length() )
+			Add(CanonicalHash(givens), givens, solution);
+	}
+	in.close();
+	file.open(fileName.c_str(), ios::app);
+}
+
+void SolutionCache::Add( uint64_t hash, const string &givens, const string &solution )
+{
+	auto found = index.find(hash);
+	if ( found != index.end() )
+	{
+		entries.erase(found->second);
+		index.erase(found);
+	}
+	entries.push_front(Entry{ hash, givens, solution });
+	index[hash] = entries.begin();
+	while ( capacity > 0 && (int)entries.size() > capacity )
+	{
+		index.erase(entries.back().hash);
+		entries.pop_back();
+	}
+}
+
+bool SolutionCache::Lookup( const CanonicalForm &form, const Board &puzzle, Board &solution )
+{
+	lock_guard<mutex> lock(cacheMutex);
+	auto found = index.find(form.hash);
+	if ( found != index.end() && found->second->givens == form.givens )
+	{
+		// move to the front, then check the mapped solution before trusting it
+		entries.splice(entries.begin(), entries, found->second);
+		Board mapped = FromCanonical(form, found->second->solution, puzzle);
+		if ( puzzle.CheckSolution(mapped) )
+		{
+			solution = mapped;
+			++hits;
+			return true;
+		}
+	}
+	++misses;
+	return false;
+}
+
+void SolutionCache::Insert( const CanonicalForm &form, const Board &solution )
+{
+	if ( form.givens.length() == 0 )
+		return;
+	string s = ToCanonical(form, solution);
+	lock_guard<mutex> lock(cacheMutex);
+	Add(form.hash, form.givens, s);
+	if ( file.is_open() )
+		file << form.givens << ' ' << s << endl;
+}
+
+SolutionCache *CreateSolutionCache( const SolverOptions &opt )
+{
+	if ( opt.cacheSize <= 0 && opt.cacheFile.length() == 0 )
+		return nullptr;
+	return new SolutionCache(opt.cacheSize > 0 ? opt.cacheSize : 10000, opt.cacheFile);
+}
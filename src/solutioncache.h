@@ -0,0 +1,50 @@
+#pragma once
+#include "canonical.h"
+#include "solveroptions.h"
+#include "board.h"
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <fstream>
+#include <cstdint>
+
+//
+// Solutions of earlier puzzles, keyed by the canonical form of their givens,
+// so that a repeat of a puzzle, or one equivalent to it under the sudoku
+// symmetries, is answered by mapping the stored solution back instead of
+// solving again. Up to capacity entries are kept, least recently used
+// dropped first. With a file name, entries are loaded from the file when
+// the cache is made and every new entry is appended to it, one
+// "givens solution" line each.
+//
+// Safe to share between threads.
+//
+class SolutionCache
+{
+	struct Entry
+	{
+		uint64_t hash;
+		std::string givens;
+		std::string solution;
+	};
+	int capacity;
+	std::list<Entry> entries;	// most recently used first
+	std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+	std::ofstream file;
+	std::mutex cacheMutex;
+	long long hits;
+	long long misses;
+
+	void Add(uint64_t hash, const std::string &givens, const std::string &solution);
+public:
+	SolutionCache(int capacity, const std::string &fileName = std::string());
+	// true, with the solution of puzzle, if an equivalent puzzle is cached
+	bool Lookup(const CanonicalForm &form, const Board &puzzle, Board &solution);
+	void Insert(const CanonicalForm &form, const Board &solution);
+	long long GetHits() const { return hits; }
+	long long GetMisses() const { return misses; }
+};
+
+// a cache for --cache / --cachefile, or nullptr if neither is set
+SolutionCache *CreateSolutionCache(const SolverOptions &opt);
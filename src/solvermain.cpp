@@ -1,106 +1,58 @@
 #include "sudokuantsystem.h"
+#include "portfolio.h"
+#include "selector.h"
+#include "solutioncache.h"
+#include "timer.h"
 #include "sudokusolver.h"
-#include "backtracksearch.h"
+#include "solveroptions.h"
+#include "puzzleio.h"
+#include "batch.h"
+#include "server.h"
+#include "packedarchive.h"
 #include "board.h"
 #include "arguments.h"
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <vector>
+#include <thread>
 using namespace std;
 
-string ReadFile( string fileName )
+int main( int argc, char *argv[] )
 {
-	char *puzString;
-	ifstream inFile;
-	inFile.open(fileName);
-	if ( inFile.is_open() )
+	// solve, then spit out 0 for success, 1 for fail, followed by time in seconds
+	Arguments a( argc, argv );
+
+	int numThreads = a.GetArg("threads", (int)std::thread::hardware_concurrency());
+	PuzzleSource *puzzles = OpenPuzzleSource(a, numThreads);
+	if ( puzzles != nullptr )
 	{
-		int firstNumber, idum;
-		inFile >> firstNumber;
-		inFile >> idum;
-		
-		// Read all values into a vector first
-		vector<int> values;
-		int val;
-		while (inFile >> val)
-		{
-			values.push_back(val);
-		}
-		inFile.close();
-		
-		// Determine format based on number of values
-		int numUnits;
-		bool isOldFormat = false;
-		
-		// Old format: firstNumber is order, has order^4 values
-		// New format: firstNumber is size, has size^2 values
-		if (values.size() == firstNumber * firstNumber * firstNumber * firstNumber)
-		{
-			// Old format (9x9, 16x16, 25x25): firstNumber is order
-			isOldFormat = true;
-			numUnits = firstNumber * firstNumber;
-		}
-		else if (values.size() == firstNumber * firstNumber)
-		{
-			// New format (6x6, 12x12): firstNumber is size
-			isOldFormat = false;
-			numUnits = firstNumber;
-		}
-		else
-		{
-			cerr << "Invalid file format: expected " << firstNumber * firstNumber 
-			     << " or " << firstNumber * firstNumber * firstNumber * firstNumber 
-			     << " values, got " << values.size() << endl;
-			return string();
-		}
-		
-		int numCells = numUnits * numUnits;
-		puzString = new char[numCells+1];
-		
-		for (int i = 0; i < numCells; i++)
+		// solve many puzzles in this process, one record per run
+		int runs = a.GetArg("runs", 1);
+
+		string packFile = a.GetArg(string("pack"),string());
+		if ( packFile.length() != 0 )
 		{
-			val = values[i];
-			if (val == -1)
-				puzString[i] = '.';
-			else if (numUnits == 6)
-				puzString[i] = '1' + (val - 1);  // 1-6 -> '1'-'6'
-			else if (numUnits == 9)
-				puzString[i] = '1' + (val - 1);  // 1-9 -> '1'-'9'
-			else if (numUnits == 12)
-			{
-				if (val <= 10)
-					puzString[i] = '0' + val - 1;  // 1-10 -> '0'-'9'
-				else
-					puzString[i] = 'a' + val - 11;  // 11-12 -> 'a'-'b'
-			}
-			else if (numUnits == 16)
-			{
-				if (val < 11)
-					puzString[i] = '0' + val - 1;
-				else
-					puzString[i] = 'a' + val - 11;
-			}
-			else  // 25x25 and larger
-				puzString[i] = 'a' + val - 1;
+			// convert to a packed archive instead of solving
+			bool written = WritePackedArchive(packFile, *puzzles);
+			delete puzzles;
+			return !written;
 		}
-		puzString[numCells] = 0;
-		inFile.close();
-		string retVal = string(puzString);
-		delete [] puzString;
-		return retVal;
+		int numFailed = RunBatch(*puzzles, ReadSolverOptions(a), runs, numThreads, cout);
+		delete puzzles;
+		return numFailed != 0;
 	}
-	else
+
+	string serveAddress = a.GetArg(string("serve"),string());
+	if ( serveAddress.length() != 0 )
 	{
-		cerr << "could not open file: " << fileName << endl;
-		return string();
+		// answer requests until killed
+		float batchWait = a.GetArg("batchwait", 2.0f) / 1000.0f;
+		return RunServer(serveAddress, ReadSolverOptions(a), numThreads, a.GetArg("batchsize", 32), batchWait);
 	}
-}
+	string connectAddress = a.GetArg(string("connect"),string());
+	if ( connectAddress.length() != 0 )
+		return RunClient(connectAddress, cin, cout, a.GetArg("timeout", 0.0f)) != 0;
 
-int main( int argc, char *argv[] )
-{
-	// solve, then spit out 0 for success, 1 for fail, followed by time in seconds
-	Arguments a( argc, argv );
 	string puzzleString;
 	if ( a.GetArg("blank", 0 ) && a.GetArg("order", 0 ))
 	{
@@ -126,27 +78,20 @@ int main( int argc, char *argv[] )
 	}
 	Board board(puzzleString);
 
-	int algorithm = a.GetArg("alg", 0);
-	int timeOutSecs = a.GetArg("timeout", 10);
-	int nAnts = a.GetArg("ants", 10);
-	float q0 = a.GetArg("q0", 0.9f);
-	float rho = a.GetArg("rho", 0.9f);
-	float evap = a.GetArg("evap", 0.005f );
+	SolverOptions opt = ReadSolverOptions(a);
 	bool blank = a.GetArg("blank", false );
 	bool verbose = a.GetArg("verbose", 0);
 	bool showInitial = a.GetArg("showinitial", 0);
+	bool anytime = a.GetArg("anytime", 0);
 	bool success;
 
 	float solTime;
 	Board solution;
-	SudokuSolver *solver;
 	
-	if ( algorithm == 0 )
-		solver = new SudokuAntSystem( nAnts, q0, rho, 1.0f/board.CellCount(), evap);
-	else
-		solver = new BacktrackSearch();
+	SudokuSolver *solver = CreateSolver(opt, board);
+	SudokuAntSystem *antSystem = dynamic_cast<SudokuAntSystem*>(solver);
+	PortfolioSolver *portfolio = dynamic_cast<PortfolioSolver*>(solver);
 
-	
 	if ( showInitial )
 	{
 		// print inital grid
@@ -154,15 +99,35 @@ int main( int argc, char *argv[] )
 		cout << board.AsString(false,true) << endl;
 	}
 	
-	success = solver->Solve(board, (float)timeOutSecs );
-	solution = solver->GetSolution();
-	solTime = solver->GetSolutionTime();
-	int iter = solver->GetCycles();
+	// answer a repeat (up to symmetry) from the cache if there is one
+	SolutionCache *cache = CreateSolutionCache(opt);
+	CanonicalForm form;
+	bool fromCache = false;
+	int iter = 0;
+	if ( cache != nullptr )
+	{
+		Timer lookupTimer;
+		lookupTimer.Reset();
+		form = Canonicalise(board);
+		fromCache = cache->Lookup(form, board, solution);
+		solTime = lookupTimer.Elapsed();
+	}
+	success = fromCache;
+	if ( !fromCache )
+	{
+		success = solver->Solve(board, opt.timeOut );
+		solution = solver->GetSolution();
+		solTime = solver->GetSolutionTime();
+		iter = solver->GetCycles();
+		if ( success && cache != nullptr && board.CheckSolution(solution) )
+			cache->Insert(form, solution);
+	}
+	delete cache;
 
 	// sanity chack the solution:
 	if ( success && !board.CheckSolution(solution) )
 	{
-		cout << "solution not valid" << a.GetArg("file",string()) << " " << algorithm << endl;
+		cout << "solution not valid" << a.GetArg("file",string()) << " " << opt.algorithm << endl;
 		cout << "numfixedCells " << solution.FixedCellCount() << endl;
 
 		string outString = solution.AsString(true );
@@ -186,6 +151,32 @@ int main( int argc, char *argv[] )
 			cout << outString << endl;
 			cout << "solved in " << solTime << endl;
 		}
+		if ( fromCache )
+			cout << "found in the solution cache" << endl;
+		if ( antSystem != nullptr && opt.antLocalTries > 0 )
+			cout << "ant local search filled " << antSystem->GetLocalSearchRepairs() << " cells in " << antSystem->GetLocalSearchTime() << " s" << endl;
+		if ( portfolio != nullptr && portfolio->GetWinner() >= 0 )
+			cout << "won by portfolio entry " << portfolio->GetWinner() << " of --portfolio " << opt.portfolio << endl;
+		if ( opt.algorithm == AUTO_ALGORITHM )
+		{
+			PuzzleFeatures f = ComputeFeatures(board);
+			SolverOptions chosen = RuleOptions(SelectRule(f), opt);
+			cout << "auto: " << f.cluePercent << "% clues, " << f.fixedPercent << "% fixed after propagation, ";
+			cout << f.meanCandidates << " candidates per open cell chose --alg " << chosen.algorithm;
+			cout << " --ants " << chosen.nAnts << " --sastall " << chosen.saStall << endl;
+		}
+	}
+	if ( anytime && !fromCache )
+	{
+		// the best board the solver got to, even if it ran out of time,
+		// and how it improved
+		cout << "Best board:" << endl;
+		cout << solution.AsString( true ) << endl;
+		cout << "cells filled " << solution.FixedCellCount() << " of " << solution.CellCount() << endl;
+		cout << "conflicts " << solution.ConflictCount() << endl;
+		cout << "time cells conflicts" << endl;
+		for ( const Improvement &m : solver->GetTrace() )
+			cout << m.time << " " << m.cellsFilled << " " << m.conflicts << endl;
 	}
 	return !int(success);
 }
@@ -0,0 +1,105 @@
+#include "solveroptions.h"
+#include "sudokuantsystem.h"
+#include "backtracksearch.h"
+#include "simulatedannealing.h"
+#include "tabusearch.h"
+#include "portfolio.h"
+#include "selector.h"
+#include <sstream>
+#include <cstdlib>
+
+SolverOptions ReadSolverOptions(Arguments &a)
+{
+	SolverOptions opt;
+	std::string algorithm = a.GetArg("alg", std::string("0"));
+	opt.algorithm = algorithm == "auto" ? AUTO_ALGORITHM : atoi(algorithm.c_str());
+	opt.timeOut = a.GetArg("timeout", 10.0f);
+	opt.nAnts = a.GetArg("ants", 10);
+	opt.q0 = a.GetArg("q0", 0.9f);
+	opt.rho = a.GetArg("rho", 0.9f);
+	opt.evap = a.GetArg("evap", 0.005f );
+	opt.prune = a.GetArg("prune", false );
+	opt.mcf = a.GetArg("mcf", false );
+	opt.adaptive = a.GetArg("adaptive", false );
+	opt.completeCells = a.GetArg("complete", 0 );
+	opt.completeNodes = a.GetArg("completenodes", 2000 );
+	opt.completeUnfix = a.GetArg("completeunfix", false );
+	opt.saReplicas = a.GetArg("sareplicas", 1 );
+	opt.saDomains = a.GetArg("sadomains", false );
+	opt.saStall = a.GetArg("sastall", 100 );
+	opt.antLocalTries = a.GetArg("antls", 0 );
+	opt.saT0 = a.GetArg("t0", 1.5f );
+	opt.saCooling = a.GetArg("cooling", 0.9999f );
+	opt.saTStop = a.GetArg("tstop", 0.01f );
+	opt.saReheat = a.GetArg("reheat", 20000 );
+	opt.tenure = a.GetArg("tenure", 10 );
+	opt.tabuRestart = a.GetArg("taburestart", 5000 );
+	opt.tabuHistory = a.GetArg("tabuhistory", 1000 );
+	opt.mmRho = a.GetArg("mmrho", 0.5f );
+	opt.stagnation = a.GetArg("stagnation", 300 );
+	opt.portfolio = a.GetArg("portfolio", std::string("0,1,3") );
+	opt.cacheSize = a.GetArg("cache", 0 );
+	opt.cacheFile = a.GetArg("cachefile", std::string() );
+	opt.seed = (unsigned int)a.GetArg("seed", 0 );
+	return opt;
+}
+
+static SudokuSolver *NewSolver(const SolverOptions &opt, const Board &puzzle)
+{
+	if ( opt.algorithm == AUTO_ALGORITHM )
+		return CreateSolver(RuleOptions(SelectRule(ComputeFeatures(puzzle)), opt), puzzle);
+	else if ( opt.algorithm == 0 || opt.algorithm == 2 )
+	{
+		SudokuAntSystem *antSystem = new SudokuAntSystem( opt.nAnts, opt.q0, opt.rho, 1.0f/puzzle.CellCount(), opt.evap);
+		antSystem->SetPruning(opt.prune);
+		antSystem->SetMostConstrainedFirst(opt.mcf);
+		antSystem->SetAdaptive(opt.adaptive);
+		antSystem->SetCompletion(opt.completeCells, opt.completeNodes, opt.completeUnfix);
+		antSystem->SetAnnealReplicas(opt.saReplicas);
+		antSystem->SetAnnealDomains(opt.saDomains);
+		antSystem->SetAnnealStall(opt.saStall);
+		antSystem->SetAntLocalSearch(opt.antLocalTries);
+		if ( opt.algorithm == 2 )
+			antSystem->SetMaxMin(opt.mmRho, opt.stagnation);
+		return antSystem;
+	}
+	else if ( opt.algorithm == 3 )
+	{
+		SudokuSA *sa = new SudokuSA(opt.saReplicas);
+		sa->SetSchedule(opt.saT0, opt.saCooling, opt.saTStop, opt.saReheat);
+		sa->SetUseDomains(opt.saDomains);
+		return sa;
+	}
+	else if ( opt.algorithm == 4 )
+	{
+		TabuSearch *tabu = new TabuSearch(opt.tenure, opt.tabuRestart, opt.tabuHistory);
+		tabu->SetUseDomains(opt.saDomains);
+		return tabu;
+	}
+	else if ( opt.algorithm == 5 )
+	{
+		// one solver per listed algorithm, all with the same settings
+		PortfolioSolver *portfolio = new PortfolioSolver();
+		std::istringstream list(opt.portfolio);
+		std::string item;
+		while ( std::getline(list, item, ',') )
+		{
+			SolverOptions member = opt;
+			member.algorithm = atoi(item.c_str());
+			if ( member.algorithm != 5 )
+				portfolio->AddSolver(CreateSolver(member, puzzle));
+		}
+		if ( portfolio->NumSolvers() == 0 )
+			portfolio->AddSolver(new BacktrackSearch());
+		return portfolio;
+	}
+	return new BacktrackSearch();
+}
+
+SudokuSolver *CreateSolver(const SolverOptions &opt, const Board &puzzle)
+{
+	SudokuSolver *solver = NewSolver(opt, puzzle);
+	if ( opt.seed != 0 )
+		solver->SetSeed(opt.seed);
+	return solver;
+}
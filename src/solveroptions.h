@@ -0,0 +1,51 @@
+#pragma once
+#include "sudokusolver.h"
+#include "board.h"
+#include "arguments.h"
+#include <string>
+
+//
+// solver settings from the command line, so that solvers can be made for
+// any number of puzzles (e.g. one per batch run) from one set of arguments
+//
+// --alg auto: the algorithm and its parameters are picked per puzzle, see selector.h
+const int AUTO_ALGORITHM = -1;
+
+struct SolverOptions
+{
+	int algorithm;
+	float timeOut;
+	int nAnts;
+	float q0;
+	float rho;
+	float evap;
+	bool prune;
+	bool mcf;
+	bool adaptive;
+	int completeCells;
+	int completeNodes;
+	bool completeUnfix;
+	int saReplicas;
+	bool saDomains;
+	int saStall;
+	int antLocalTries;
+	float saT0;
+	float saCooling;
+	float saTStop;
+	int saReheat;
+	int tenure;
+	int tabuRestart;
+	int tabuHistory;
+	float mmRho;
+	int stagnation;
+	std::string portfolio;	// algorithms raced by --alg 5, e.g. "0,1,3"
+	int cacheSize;			// solutions kept for repeats up to symmetry, 0 for no cache
+	std::string cacheFile;	// also keep them in this file between runs
+	unsigned int seed;		// every random stream is derived from it, 0 for a random seed
+};
+
+SolverOptions ReadSolverOptions(Arguments &a);
+
+// a new solver for the puzzle, owned by the caller, seeded if opt.seed is set.
+// With AUTO_ALGORITHM the selector chooses the solver from the puzzle's features
+SudokuSolver *CreateSolver(const SolverOptions &opt, const Board &puzzle);
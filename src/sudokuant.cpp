@@ -6,79 +6,305 @@ void SudokuAnt::InitSolution(const Board &puzzle, int startCell )
 	sol.Copy(puzzle);
 	iCell = startCell;
 	failCells = 0;
-	if (roulette != nullptr)
+	abandoned = false;
+	done = false;
+	if (rouletteSize != puzzle.GetNumUnits())
 	{
+		// only reallocate when the geometry changes
 		delete[] roulette;
 		delete[] rouletteVals;
+		rouletteSize = puzzle.GetNumUnits();
+		roulette = new float[rouletteSize];
+		rouletteVals = new ValueSet[rouletteSize];
 	}
-	roulette = new float[puzzle.GetNumUnits()];
-	rouletteVals = new ValueSet[puzzle.GetNumUnits()];
+
+	mostConstrainedFirst = parent->MostConstrainedFirst();
+	if (mostConstrainedFirst)
+	{
+		int numCells = sol.CellCount();
+		bucketHead.assign(sol.GetNumUnits() + 1, -1);
+		bucketOf.assign(numCells, -1);
+		nextCell.resize(numCells);
+		prevCell.resize(numCells);
+		minBucket = sol.GetNumUnits() + 1;
+		// insert starting from the ant's start cell, so that ants break ties
+		// between equally constrained cells differently
+		for (int i = 0; i < numCells; i++)
+		{
+			int cell = (startCell + i) % numCells;
+			int count = sol.GetCell(cell).Count();
+			if (count > 1)
+				BucketInsert(cell, count);
+		}
+		changed.clear();
+		sol.SetChangeLog(&changed);
+	}
+	else
+		sol.SetChangeLog(nullptr);
+}
+
+void SudokuAnt::BucketInsert(int cell, int count)
+{
+	bucketOf[cell] = count;
+	prevCell[cell] = -1;
+	nextCell[cell] = bucketHead[count];
+	if (bucketHead[count] != -1)
+		prevCell[bucketHead[count]] = cell;
+	bucketHead[count] = cell;
+	if (count < minBucket)
+		minBucket = count;
+}
+
+void SudokuAnt::BucketRemove(int cell)
+{
+	int count = bucketOf[cell];
+	if (prevCell[cell] != -1)
+		nextCell[prevCell[cell]] = nextCell[cell];
+	else
+		bucketHead[count] = nextCell[cell];
+	if (nextCell[cell] != -1)
+		prevCell[nextCell[cell]] = prevCell[cell];
+	bucketOf[cell] = -1;
+}
+
+void SudokuAnt::BucketUpdate(int cell)
+{
+	// possibilities only ever shrink, so a cell moves to a lower bucket or
+	// leaves the structure once it is fixed or empty
+	int count = sol.GetCell(cell).Count();
+	if (bucketOf[cell] == count)
+		return;
+	if (bucketOf[cell] != -1)
+		BucketRemove(cell);
+	if (count > 1)
+		BucketInsert(cell, count);
+}
+
+int SudokuAnt::NextMostConstrained()
+{
+	for (size_t i = 0; i < changed.size(); i++)
+		BucketUpdate(changed[i]);
+	changed.clear();
+	while (minBucket < (int)bucketHead.size() && bucketHead[minBucket] == -1)
+		++minBucket;
+	if (minBucket == (int)bucketHead.size())
+		return -1;
+	return bucketHead[minBucket];
+}
+
+void SudokuAnt::Abandon()
+{
+	// stop constructing - the remaining cells are left unvisited. Count every
+	// infeasible cell as a failure so that NumCellsFilled reports the best
+	// this ant could have achieved.
+	abandoned = true;
+	done = true;
+	failCells = sol.InfeasibleCellCount();
 }
 
 void SudokuAnt::StepSolution()
 {
+	if (done)
+		return;
+	if (mostConstrainedFirst)
+	{
+		// fill the open cell with fewest possibilities. Fixed and empty cells
+		// never enter the buckets, so the failures are counted at the end.
+		iCell = NextMostConstrained();
+		if (iCell == -1)
+		{
+			failCells = sol.InfeasibleCellCount();
+			done = true;
+			return;
+		}
+		ChooseValue();
+		return;
+	}
 	if (sol.GetCell(iCell).Empty())
 	{
 		failCells++;
 	}
 	else if ( !sol.GetCell(iCell).Fixed() )
 	{
-		// make a choice from the options
-		ValueSet choice = ValueSet(sol.GetNumUnits(), 1);
-		if (parent->random() > parent->Getq0())
-		{
-			// greedy selection
-			ValueSet best;
-			float maxPher = -1.0f;
+		ChooseValue();
+	}
+	++iCell;
+	if (iCell == sol.CellCount()) // wrap around
+		iCell = 0;
+}
+
+void SudokuAnt::ChooseValue()
+{
+	// make a choice from the options
+	ValueSet choice = ValueSet(sol.GetNumUnits(), 1);
+	if (parent->random() > parent->Getq0())
+	{
+		// greedy selection
+		ValueSet best;
+		float maxPher = -1.0f;
 
-			for (int i = 0; i < sol.GetNumUnits(); i++)
+		for (int i = 0; i < sol.GetNumUnits(); i++)
+		{
+			if (sol.GetCell(iCell).Contains(choice))
 			{
-				if (sol.GetCell(iCell).Contains(choice))
+				if (parent->Pher(iCell, i) > maxPher)
 				{
-					if (parent->Pher(iCell, i) > maxPher)
-					{
-						maxPher = parent->Pher(iCell, i);
-						best = choice;
-					}
+					maxPher = parent->Pher(iCell, i);
+					best = choice;
 				}
-				choice <<= 1;
 			}
-			sol.SetCell(iCell, best);
-			// do local pheromone update here
-			parent->LocalPheromoneUpdate(iCell, best.Index());
+			choice <<= 1;
+		}
+		sol.SetCell(iCell, best);
+		// do local pheromone update here
+		parent->LocalPheromoneUpdate(iCell, best.Index());
+	}
+	else
+	{
+		// weighted selection
+		float totPher = 0.0f;
+		int numChoices = 0;
+		for (int i = 0; i < sol.GetNumUnits(); i++)
+		{
+			if (sol.GetCell(iCell).Contains(choice))
+			{
+				roulette[numChoices] = totPher + parent->Pher(iCell, i);
+				totPher = roulette[numChoices];
+				rouletteVals[numChoices] = choice;
+				++numChoices;
+			}
+			choice <<= 1;
+		}
+		float rouletteVal = totPher * parent->random();
+
+		for (int i = 0; i < numChoices; i++)
+		{
+			if (roulette[i] > rouletteVal)
+			{
+				sol.SetCell(iCell, rouletteVals[i]);
+				// do local pheromone update here
+				parent->LocalPheromoneUpdate(iCell, rouletteVals[i].Index());
+				break;
+			}
 		}
+	}
+}
+
+
+void SudokuAnt::LocalPlace(int cell, int v)
+{
+	int numUnits = sol.GetNumUnits();
+	lsValue[cell] = v;
+	lsHolder[sol.RowForCell(cell)*numUnits + v] = cell;
+	lsHolder[(numUnits + sol.ColForCell(cell))*numUnits + v] = cell;
+	lsHolder[(2*numUnits + sol.BoxForCell(cell))*numUnits + v] = cell;
+}
+
+void SudokuAnt::LocalRemove(int cell)
+{
+	int numUnits = sol.GetNumUnits();
+	int v = lsValue[cell];
+	lsValue[cell] = -1;
+	lsHolder[sol.RowForCell(cell)*numUnits + v] = -1;
+	lsHolder[(numUnits + sol.ColForCell(cell))*numUnits + v] = -1;
+	lsHolder[(2*numUnits + sol.BoxForCell(cell))*numUnits + v] = -1;
+}
+
+int SudokuAnt::LocalImprove(const Board &puzzle, int maxTries)
+{
+	// Repair empty cells by single ejections: give an empty cell a value
+	// whose only holder among its peers is a cell the puzzle leaves open, if
+	// that peer can move to another value. Each repair fills one more cell.
+	// Stops after maxTries (cell, value) trials or when a pass finds nothing.
+	int numUnits = sol.GetNumUnits();
+	int numCells = sol.CellCount();
+	lsValue.assign(numCells, -1);
+	lsHolder.assign(3*numUnits*numUnits, -1);
+	std::vector<int> empty;
+	for (int i = 0; i < numCells; i++)
+	{
+		if (sol.GetCell(i).Fixed())
+			LocalPlace(i, sol.GetCell(i).Index());
 		else
+			empty.push_back(i);
+	}
+
+	std::vector<int> changed;
+	int tries = 0;
+	bool progress = true;
+	while (progress && tries < maxTries)
+	{
+		progress = false;
+		for (size_t k = 0; k < empty.size() && tries < maxTries; k++)
 		{
-			// weighted selection
-			float totPher = 0.0f;
-			int numChoices = 0;
-			for (int i = 0; i < sol.GetNumUnits(); i++)
+			int e = empty[k];
+			if (lsValue[e] >= 0)
+				continue;
+			int row = sol.RowForCell(e), col = sol.ColForCell(e), box = sol.BoxForCell(e);
+			for (int v = 0; v < numUnits && tries < maxTries; v++)
 			{
-				if (sol.GetCell(iCell).Contains(choice))
+				if (!puzzle.GetCell(e).Contains((uint64_t)1 << v))
+					continue;
+				++tries;
+				int holders[3] = { lsHolder[row*numUnits + v], lsHolder[(numUnits + col)*numUnits + v], lsHolder[(2*numUnits + box)*numUnits + v] };
+				int p = -1;
+				bool single = true;
+				for (int h : holders)
 				{
-					roulette[numChoices] = totPher + parent->Pher(iCell, i);
-					totPher = roulette[numChoices];
-					rouletteVals[numChoices] = choice;
-					++numChoices;
+					if (h < 0 || h == p)
+						continue;
+					if (p >= 0)
+						single = false;
+					p = h;
 				}
-				choice <<= 1;
-			}
-			float rouletteVal = totPher * parent->random();
+				if (!single)
+					continue;
+				if (p < 0)
+				{
+					// nothing blocks it any more
+					LocalPlace(e, v);
+					changed.push_back(e);
+					progress = true;
+					break;
+				}
+				if (puzzle.GetCell(p).Fixed())
+					continue;
 
-			for (int i = 0; i < numChoices; i++)
-			{
-				if (roulette[i] > rouletteVal)
+				int old = lsValue[p];
+				LocalRemove(p);
+				LocalPlace(e, v);
+				int pRow = sol.RowForCell(p), pCol = sol.ColForCell(p), pBox = sol.BoxForCell(p);
+				int w;
+				for (w = 0; w < numUnits; w++)
 				{
-					sol.SetCell(iCell, rouletteVals[i]);
-					// do local pheromone update here
-					parent->LocalPheromoneUpdate(iCell, rouletteVals[i].Index());
+					if (w != old && puzzle.GetCell(p).Contains((uint64_t)1 << w) &&
+						lsHolder[pRow*numUnits + w] < 0 &&
+						lsHolder[(numUnits + pCol)*numUnits + w] < 0 &&
+						lsHolder[(2*numUnits + pBox)*numUnits + w] < 0)
+						break;
+				}
+				if (w < numUnits)
+				{
+					LocalPlace(p, w);
+					changed.push_back(e);
+					changed.push_back(p);
+					progress = true;
 					break;
 				}
+				LocalRemove(e);
+				LocalPlace(p, old);
 			}
 		}
 	}
-	++iCell;
-	if (iCell == sol.CellCount()) // wrap around
-		iCell = 0;
-}
 
+	// write the repairs back to the board
+	for (int cell : changed)
+	{
+		const ValueSet &current = sol.GetCell(cell);
+		if (!current.Fixed() || current.Index() != lsValue[cell])
+			sol.ForceSetCell(cell, ValueSet(numUnits, (uint64_t)1 << lsValue[cell]));
+	}
+	int gained = failCells - sol.InfeasibleCellCount();
+	failCells = sol.InfeasibleCellCount();
+	return gained;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "board.h"
+#include <vector>
 
 class SudokuAntSystem;
 
@@ -9,13 +10,50 @@ class SudokuAnt
 	int iCell;	// current cell
 	SudokuAntSystem *parent;	// parent ant system
 	int failCells;	// no of cells on this attempt which were unsettable
+	bool abandoned;	// true if the ant gave up on this attempt (see Abandon)
+	bool done;	// true once there is nothing left to construct
 	float *roulette; // working array for the roulette wheel selection
 	ValueSet *rouletteVals; // working array for the roulette wheel selection
+	int rouletteSize;	// entries allocated in the roulette arrays
+
+	// most-constrained-first ordering: open cells are kept in doubly linked
+	// lists bucketed by their number of possibilities
+	bool mostConstrainedFirst;
+	std::vector<int> changed;	// change log filled in by the board
+	std::vector<int> bucketHead;	// first cell with a given count, -1 if none
+	std::vector<int> bucketOf;	// bucket each cell is in, -1 if none
+	std::vector<int> nextCell, prevCell;
+	int minBucket;	// no bucket below this one has any cells
+	void BucketInsert(int cell, int count);
+	void BucketRemove(int cell);
+	void BucketUpdate(int cell);
+	int NextMostConstrained();
+	void ChooseValue();
+
+	// local improvement: value in each cell (-1 if empty) and, for each
+	// row, column and box, the cell holding each value (-1 if none)
+	std::vector<int> lsValue;
+	std::vector<int> lsHolder;
+	void LocalPlace(int cell, int v);
+	void LocalRemove(int cell);
 
 public:	
-	SudokuAnt(SudokuAntSystem *parent) : parent(parent), iCell(0), roulette(nullptr), rouletteVals(nullptr) {}
+	SudokuAnt(SudokuAntSystem *parent) : parent(parent), iCell(0), abandoned(false), done(false), roulette(nullptr), rouletteVals(nullptr), rouletteSize(0), mostConstrainedFirst(false) {}
+	~SudokuAnt()
+	{
+		delete[] roulette;
+		delete[] rouletteVals;
+	}
 	void InitSolution(const Board &puzzle, int ic);
 	void StepSolution();
+	void Abandon();
+	int LocalImprove(const Board &puzzle, int maxTries);
+	bool Done() const { return done; }
+	bool Abandoned() const { return abandoned; }
 	const Board& GetSolution() { return sol; }
 	int NumCellsFilled() { return sol.CellCount() - failCells; }
+	// upper bound on the number of cells this ant can still fill - cells
+	// which are already empty can never be set
+	int MaxCellsFilled() const { return sol.CellCount() - sol.InfeasibleCellCount(); }
+	int MinCellsFilled() const { return sol.FixedCellCount(); }
 };
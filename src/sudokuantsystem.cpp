@@ -1,24 +1,67 @@
 #include "sudokuantsystem.h"
 #include "simulatedannealing.h"
+#include "backtracksearch.h"
 #include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <atomic>
 
 void SudokuAntSystem::InitPheromone(int nNumCells, int valuesPerCell )
 {
+	// the matrix is kept between solves and only reallocated if the
+	// geometry changes
+	if (pher != nullptr && (nNumCells != numCells || valuesPerCell != pherValues))
+		ClearPheromone();
 	numCells = nNumCells;
-	pher = new float*[numCells];
+	if (pher == nullptr)
+	{
+		pherValues = valuesPerCell;
+		pher = new float*[numCells];
+		for (int i = 0; i < numCells; i++)
+			pher[i] = new float[valuesPerCell];
+	}
 	for (int i = 0; i < numCells; i++)
 	{
-		pher[i] = new float[valuesPerCell];
 		for (int j = 0; j < valuesPerCell; j++)
 			pher[i][j] = pher0;
 	}
 }
 
+void SudokuAntSystem::SeedPheromone(const Board& puzzle)
+{
+	// deposit as for a best-so-far solution made of the warm start's values
+	// which the puzzle still allows. MMAS resets the matrix at its first
+	// update, so only ACS uses this.
+	hasWarmStart = false;
+	if (maxMin || warmStart.CellCount() != numCells)
+		return;
+	int kept = 0;
+	for (int i = 0; i < numCells; i++)
+	{
+		const ValueSet &cell = warmStart.GetCell(i);
+		if (cell.Fixed() && puzzle.GetCell(i).Contains(cell))
+			++kept;
+	}
+	if (kept == numCells)
+		kept = numCells - 1;
+	float deposit = PherAdd(kept);
+	for (int i = 0; i < numCells; i++)
+	{
+		const ValueSet &cell = warmStart.GetCell(i);
+		if (cell.Fixed() && puzzle.GetCell(i).Contains(cell))
+			pher[i][cell.Index()] = pher[i][cell.Index()] * (1.0f - rho) + rho*deposit;
+	}
+}
+
 void SudokuAntSystem::ClearPheromone()
 {
+	if (pher == nullptr)
+		return;
 	for (int i = 0; i < numCells; i++)
 		delete[] pher[i];
 	delete[] pher;
+	pher = nullptr;
 }
 
 float SudokuAntSystem::PherAdd( int cellsFilled)
@@ -26,6 +69,40 @@ float SudokuAntSystem::PherAdd( int cellsFilled)
 	return numCells / (float)(numCells - cellsFilled);
 }
 
+bool SudokuAntSystem::CanImprove(int maxCellsFilled, int iterMinCellsFilled)
+{
+	// an ant can only affect the pheromone if it ends up as the iteration best
+	// and its deposit is bigger than the (decayed) best value
+	if (maxCellsFilled < iterMinCellsFilled)
+		return false;
+	if (maxMin)
+		return true; // the iteration best always deposits
+	return PherAdd(maxCellsFilled) > bestPher;
+}
+
+int SudokuAntSystem::PruneAnts()
+{
+	// fixed cells stay fixed, so every ant will fill at least as
+	// many cells as the best lower bound seen so far
+	int iterMin = 0;
+	for (auto a : antList)
+	{
+		if (!a->Done() && a->MinCellsFilled() > iterMin)
+			iterMin = a->MinCellsFilled();
+	}
+	int numActive = 0;
+	for (auto a : antList)
+	{
+		if (a->Done())
+			continue;
+		if (!CanImprove(a->MaxCellsFilled(), iterMin))
+			a->Abandon();
+		else
+			++numActive;
+	}
+	return numActive;
+}
+
 void SudokuAntSystem::UpdatePheromone()
 {
 	for (int i = 0; i < numCells; i++)
@@ -37,8 +114,277 @@ void SudokuAntSystem::UpdatePheromone()
 	}
 }
 
+void SudokuAntSystem::SetMaxMin(float nmmRho, int nStagnationIters)
+{
+	maxMin = true;
+	mmRho = nmmRho;
+	baseMmRho = nmmRho;
+	stagnationIters = nStagnationIters;
+}
+
+void SudokuAntSystem::MaxMinUpdate(const Board& iterBestSol, int iterBestVal)
+{
+	// the bounds follow the best-so-far value (Stutzle & Hoos), with tauMin
+	// set so that an ant reconstructs the best solution with probability pBest
+	const float pBest = 0.05f;
+	int valuesPerCell = iterBestSol.GetNumUnits();
+	float pDec = pow(pBest, 1.0f / numCells);
+	tauMax = PherAdd(bestVal) / mmRho;
+	tauMin = tauMax * (1.0f - pDec) / ((valuesPerCell / 2.0f - 1.0f) * pDec);
+
+	if (resetPheromone)
+	{
+		for (int i = 0; i < numCells; i++)
+			for (int j = 0; j < valuesPerCell; j++)
+				pher[i][j] = tauMax;
+		resetPheromone = false;
+	}
+
+	// deposit with the iteration best to begin with, using the best-so-far
+	// more and more often as the run since the last restart goes on
+	int sinceRestart = iter - restartIter;
+	int bestFreq = sinceRestart < 25 ? 0 : sinceRestart < 75 ? 5 : sinceRestart < 125 ? 3 : sinceRestart < 250 ? 2 : 1;
+	bool useBest = bestFreq != 0 && (sinceRestart % bestFreq) == 0;
+	const Board &depositSol = useBest ? bestSol : iterBestSol;
+	float deposit = PherAdd(useBest ? bestVal : iterBestVal);
+
+	for (int i = 0; i < numCells; i++)
+	{
+		float *p = pher[i];
+		for (int j = 0; j < valuesPerCell; j++)
+			p[j] *= (1.0f - mmRho);
+		if (depositSol.GetCell(i).Fixed())
+			p[depositSol.GetCell(i).Index()] += deposit;
+		for (int j = 0; j < valuesPerCell; j++)
+		{
+			if (p[j] > tauMax)
+				p[j] = tauMax;
+			else if (p[j] < tauMin)
+				p[j] = tauMin;
+		}
+	}
+
+	// restart on stagnation: no improvement for too long, or the pheromone
+	// has converged to (close to) a single value in every cell
+	bool stagnated = iter - lastImprovement > stagnationIters;
+	if (!stagnated && (sinceRestart % 25) == 24)
+	{
+		float r = tauMin / tauMax;
+		float pMax = 1.0f / (1.0f + (valuesPerCell - 1) * r);
+		float pMin = r * pMax;
+		float converged = -(pMax * log(pMax) + (valuesPerCell - 1) * pMin * log(pMin)) / log((float)valuesPerCell);
+		stagnated = PheromoneEntropy(valuesPerCell) < converged + 0.05f;
+	}
+	if (stagnated)
+	{
+		resetPheromone = true;
+		restartIter = iter + 1;
+		lastImprovement = iter;
+	}
+}
+
+float SudokuAntSystem::PheromoneEntropy(int valuesPerCell)
+{
+	// mean normalised entropy of the per-cell pheromone distributions
+	float total = 0.0f;
+	for (int i = 0; i < numCells; i++)
+	{
+		float sum = 0.0f;
+		for (int j = 0; j < valuesPerCell; j++)
+			sum += pher[i][j];
+		float h = 0.0f;
+		for (int j = 0; j < valuesPerCell; j++)
+		{
+			float p = pher[i][j] / sum;
+			if (p > 0.0f)
+				h -= p * log(p);
+		}
+		total += h;
+	}
+	return total / (numCells * log((float)valuesPerCell));
+}
+
+void SudokuAntSystem::InitAdaptive(const Board& puzzle)
+{
+	// every solve starts from the configured values
+	q0 = baseQ0;
+	rho = baseRho;
+	bestEvap = baseEvap;
+	mmRho = baseMmRho;
+
+	// pick a small random sample of open cells to measure diversity on
+	const size_t numSamples = 16;
+	sampleCells.clear();
+	for (int i = 0; i < puzzle.CellCount(); i++)
+	{
+		if (!puzzle.GetCell(i).Fixed())
+			sampleCells.push_back(i);
+	}
+	std::shuffle(sampleCells.begin(), sampleCells.end(), randGen);
+	if (sampleCells.size() > numSamples)
+		sampleCells.resize(numSamples);
+}
+
+float SudokuAntSystem::AntDiversity()
+{
+	// fraction of the possible distinct values the ants chose, averaged over
+	// the sample cells: 0 when all ants agree, 1 when they all differ
+	if (sampleCells.empty() || antList.size() < 2)
+		return 0.0f;
+	int numValues = antList[0]->GetSolution().GetNumUnits();
+	int maxDistinct = (int)antList.size() < numValues ? (int)antList.size() : numValues;
+	float total = 0.0f;
+	for (size_t i = 0; i < sampleCells.size(); i++)
+	{
+		ValueSet chosen(numValues);
+		for (auto a : antList)
+		{
+			const ValueSet &c = a->GetSolution().GetCell(sampleCells[i]);
+			if (c.Fixed())
+				chosen += c;
+		}
+		if (chosen.Count() > 1)
+			total += (chosen.Count() - 1) / (float)(maxDistinct - 1);
+	}
+	return total / sampleCells.size();
+}
+
+void SudokuAntSystem::AdaptParameters()
+{
+	// note that ants make the greedy choice when random() > q0, so raising
+	// q0 makes the colony explore more
+	// q0, and rho and bestEvap for ACS; MMAS reads neither of those and
+	// evaporates with mmRho, whose tauMax = deposit / mmRho also widens
+	// the pheromone bounds as it falls. Progress is the fullest board
+	// growing, not ACS's evaporating best being replaced.
+	const int window = 20;
+	bool stalled = iter - lastGrowth > window;
+	float diversity = AntDiversity();
+
+	if (!stalled)
+	{
+		// making progress - drift back towards the configured values
+		q0 += 0.1f * (baseQ0 - q0);
+		rho += 0.1f * (baseRho - rho);
+		bestEvap += 0.1f * (baseEvap - bestEvap);
+		mmRho += 0.1f * (baseMmRho - mmRho);
+	}
+	else if (diversity < 0.25f)
+	{
+		// stuck and converged - explore, deposit less and let the best
+		// value evaporate faster so a different best can take over
+		q0 = std::min(0.99f, q0 + 0.01f);
+		if (maxMin)
+			mmRho = std::max(0.01f, mmRho * 0.95f);
+		else
+		{
+			rho = std::max(0.1f, rho * 0.95f);
+			bestEvap = std::min(0.05f, bestEvap * 1.2f);
+		}
+	}
+	else if (diversity > 0.6f)
+	{
+		// stuck but the ants are all over the place - be greedier
+		q0 = std::max(0.5f, q0 - 0.01f);
+		if (maxMin)
+			mmRho = std::min(0.95f, mmRho * 1.05f);
+		else
+		{
+			rho = std::min(0.95f, rho * 1.05f);
+			bestEvap = std::max(0.0005f, bestEvap * 0.9f);
+		}
+	}
+}
+
+bool SudokuAntSystem::CompleteBest(const Board& puzzle, float maxTime)
+{
+	// Try to finish the best solution with a bounded backtracking search.
+	// Its values are put back onto the puzzle most reinforced first, skipping
+	// any that would leave a cell with no possibilities, and the search then
+	// tries values in order of pheromone.
+	int numUnits = puzzle.GetNumUnits();
+	std::vector<bool> keep(numCells);
+	float meanPher = 0.0f;
+	int numKept = 0;
+	for (int i = 0; i < numCells; i++)
+	{
+		keep[i] = !puzzle.GetCell(i).Fixed() && bestSol.GetCell(i).Fixed();
+		if (keep[i])
+		{
+			meanPher += pher[i][bestSol.GetCell(i).Index()];
+			++numKept;
+		}
+	}
+	if (completeUnfix && numKept > 0)
+	{
+		// give the search room around each empty cell by also releasing
+		// its neighbours which are less reinforced than average
+		meanPher /= numKept;
+		for (int i = 0; i < numCells; i++)
+		{
+			if (!bestSol.GetCell(i).Empty())
+				continue;
+			int iRow = bestSol.RowForCell(i), iCol = bestSol.ColForCell(i), iBox = bestSol.BoxForCell(i);
+			for (int j = 0; j < numUnits; j++)
+			{
+				int peers[3] = { bestSol.RowCell(iRow, j), bestSol.ColCell(iCol, j), bestSol.BoxCell(iBox, j) };
+				for (int k = 0; k < 3; k++)
+				{
+					int c = peers[k];
+					if (keep[c] && pher[c][bestSol.GetCell(c).Index()] < meanPher)
+						keep[c] = false;
+				}
+			}
+		}
+	}
+
+	std::vector<int> order;
+	for (int i = 0; i < numCells; i++)
+	{
+		if (keep[i])
+			order.push_back(i);
+	}
+	std::sort(order.begin(), order.end(), [this](int a, int b) {
+		return pher[a][bestSol.GetCell(a).Index()] > pher[b][bestSol.GetCell(b).Index()];
+	});
+
+	Board partial(puzzle), trial;
+	for (int i : order)
+	{
+		const ValueSet &v = bestSol.GetCell(i);
+		if (partial.GetCell(i).Fixed() || !partial.GetCell(i).Contains(v))
+			continue;
+		trial.Copy(partial);
+		trial.SetCell(i, v);
+		if (trial.InfeasibleCellCount() == partial.InfeasibleCellCount())
+			partial.Copy(trial);
+	}
+
+	BacktrackSearch search;
+	search.SetNodeLimit(completeNodes);
+	search.SetValueWeights(pher);
+	search.SetStopFlag(stopFlag);
+	if (!search.Solve(partial, maxTime))
+		return false;
+	bestSol.Copy(search.GetSolution());
+	return true;
+}
+
+void SudokuAntSystem::KeepBest(const Board& board, int val)
+{
+	// the result if time runs out, and the improvement trace, only ever grow
+	if (val <= keptVal)
+		return;
+	keptSol.Copy(board);
+	keptVal = val;
+	lastGrowth = iter;
+	RecordImprovement(solutionTimer.Elapsed(), keptVal, 0);
+}
+
 void SudokuAntSystem::LocalPheromoneUpdate(int iCell, int iChoice)
 {
+	if (maxMin)
+		return; // MMAS has no local update
 	pher[iCell][iChoice] = pher[iCell][iChoice] * 0.9f + pher0*0.1f;
 }
 
@@ -48,8 +394,31 @@ bool SudokuAntSystem::Solve(const Board& puzzle, float maxTime )
 	iter = 0;
 	bool solved = false;
 	bestPher = 0.0f;
-	int curBestAnt = 0;
+	bestVal = 0;
+	bestSol.Copy(puzzle);	// the best answer until an ant finds a better one
+	keptSol.Copy(puzzle);
+	keptVal = 0;
+	lastGrowth = 0;
+	resetPheromone = true;
+	restartIter = 0;
+	lastImprovement = 0;
+	localSearchTime = 0.0f;
+	localSearchRepairs = 0;
+	trace.clear();
 	InitPheromone( puzzle.CellCount(), puzzle.GetNumUnits() );
+	if (hasWarmStart)
+		SeedPheromone(puzzle);
+	if (adaptive)
+		InitAdaptive(puzzle);
+
+	// background annealer, working on a snapshot of the best solution
+	SudokuSA *annealer = nullptr;
+	std::thread annealThread;
+	std::atomic<bool> annealDone(false), annealStop(false);
+	int annealCost = 0;
+	int lastAnneal = 0;
+
+	bool outOfTime = false;
 	while (!solved)
 	{
 		// start each ant on a different square
@@ -62,63 +431,157 @@ bool SudokuAntSystem::Solve(const Board& puzzle, float maxTime )
 		for (int i = 0; i < puzzle.CellCount(); i++)
 		{
 			// step each ant in turn
+			int numActive = 0;
 			for (auto a : antList)
 			{
 				a->StepSolution();
+				if (!a->Done())
+					++numActive;
 			}
+			if (prune)
+				numActive = PruneAnts();
+			// an iteration on a large board can take longer than the whole
+			// time allowed, so the deadline is also checked within it
+			if ((i % 16) == 15 && solutionTimer.Elapsed() > maxTime)
+				outOfTime = true;
+			if (numActive == 0 || outOfTime || StopRequested())
+				break;
+		}
+		if (outOfTime || StopRequested())
+		{
+			// the ants' part-built boards are consistent, so one may
+			// still beat the best complete iteration
+			for (auto a : antList)
+				KeepBest(a->GetSolution(), a->GetSolution().FixedCellCount());
+			break;
+		}
+		// optional repair of each ant's board, timed on its own
+		if (antLocalTries > 0)
+		{
+			localSearchTimer.Reset();
+			for (auto a : antList)
+			{
+				if (!a->Abandoned())
+					localSearchRepairs += a->LocalImprove(puzzle, antLocalTries);
+			}
+			localSearchTime += localSearchTimer.Elapsed();
 		}
 		// update pheromone
 		int iBest = 0;
-		int bestVal = 0;
+		int iterBestVal = 0;
 		for (unsigned int i = 0; i < antList.size(); i++)
 		{
-			if (antList[i]->NumCellsFilled() > bestVal)
+			if (antList[i]->NumCellsFilled() > iterBestVal)
 			{
-				bestVal = antList[i]->NumCellsFilled();
+				iterBestVal = antList[i]->NumCellsFilled();
 				iBest = i;
 			}
 		}
-		float pherToAdd = PherAdd(bestVal);
-
-		
+		float pherToAdd = PherAdd(iterBestVal);
 
-		if (pherToAdd > bestPher)
+		// MMAS keeps the true best-so-far, ACS lets the best value evaporate
+		if ((maxMin && iterBestVal > bestVal) || (!maxMin && pherToAdd > bestPher))
 		{
 			// new best
 			bestSol.Copy(antList[iBest]->GetSolution());
 			bestPher = pherToAdd;
-			curBestAnt = bestVal;
+			bestVal = iterBestVal;
+			lastImprovement = iter;
+			KeepBest(bestSol, bestVal);
 			if (bestVal == numCells)
 			{
 				solved = true;
 				solTime = solutionTimer.Elapsed();
 			}
+			else if (numCells - bestVal <= completeCells)
+			{
+				float timeLeft = maxTime - solutionTimer.Elapsed();
+				if (timeLeft > 0.0f && CompleteBest(puzzle, timeLeft))
+				{
+					solved = true;
+					solTime = solutionTimer.Elapsed();
+					RecordImprovement(solTime, numCells, 0);
+				}
+			}
 		}
-		if ((iter % 100) == 0 and iter !=0){
-			SudokuSA sa(bestSol);
-			int cost = sa.Anneal();
-			bestSol.Copy(sa.GetSolution());
-			if (cost == 0){
+		if (annealer != nullptr && (annealDone || seeded))
+		{
+			// merge the annealed board at the iteration boundary. With a
+			// seed, wait for it, so that the merge always comes at the same
+			// iteration (the annealer's own run is a fixed number of moves)
+			annealThread.join();
+			const Board &annealed = annealer->GetSolution();
+			if (!solved && annealCost == 0)
+			{
+				bestSol.Copy(annealed);
+				bestVal = numCells;
 				solved = true;
 				solTime = solutionTimer.Elapsed();
+				RecordImprovement(solTime, numCells, 0);
 			}
+			else if (!solved && annealed.FixedCellCount() > bestVal)
+			{
+				bestSol.Copy(annealed);
+				bestVal = annealed.FixedCellCount();
+				bestPher = PherAdd(bestVal);
+				lastImprovement = iter;
+				KeepBest(bestSol, bestVal);
+			}
+			delete annealer;
+			annealer = nullptr;
+		}
+		if (!solved && annealer == nullptr && iter - std::max(lastImprovement, lastAnneal) >= saStall)
+		{
+			// the best has stalled: anneal a snapshot of it while the ants go on
+			annealer = new SudokuSA(bestSol, saReplicas);
+			annealer->SetSeed(DeriveSeed(randGen(), 1));
+			if (saDomains)
+				annealer->SetDomains(puzzle);
+			annealer->SetStopFlag(&annealStop);
+			annealDone = false;
+			lastAnneal = iter;
+			float timeLeft = maxTime - solutionTimer.Elapsed();
+			annealThread = std::thread([annealer, timeLeft, &annealCost, &annealDone]() {
+				annealCost = annealer->Anneal(timeLeft);
+				annealDone = true;
+			});
+		}
+		if (adaptive && !solved)
+			AdaptParameters();
+		if (maxMin)
+		{
+			if (!solved)
+				MaxMinUpdate(antList[iBest]->GetSolution(), iterBestVal);
+		}
+		else
+		{
+			UpdatePheromone();
+			bestPher *= (1.0f - bestEvap);
 		}
-		UpdatePheromone();
-		bestPher *= (1.0f - bestEvap);
 		++iter;
 
-		// check timer every 100 iterations
-		if ((iter % 100) == 0)
+		// check timer every iteration
+		if (solutionTimer.Elapsed() > maxTime)
+			break;
+	}
+	if (annealer != nullptr)
+	{
+		annealStop = true;
+		annealThread.join();
+		if (!solved && annealCost == 0)
 		{
-			float elapsed = solutionTimer.Elapsed();
-			if ( elapsed > maxTime)
-			{
-				break;
-			}
+			bestSol.Copy(annealer->GetSolution());
+			solved = true;
+			solTime = solutionTimer.Elapsed();
+			RecordImprovement(solTime, numCells, 0);
 		}
-		
+		delete annealer;
+	}
+	if (!solved)
+	{
+		solTime = solutionTimer.Elapsed();
+		bestSol.Copy(keptSol);
 	}
-	ClearPheromone();
 	return solved;
 	
 }
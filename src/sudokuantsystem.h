@@ -1,6 +1,6 @@
 #pragma once
 #include <vector>
-#include <random>
+#include "random.h"
 #include "sudokuant.h"
 #include "board.h"
 #include "timer.h"
@@ -16,33 +16,89 @@ class SudokuAntSystem : public SudokuSolver
 	Board bestSol;
 	float bestPher;
 	int bestVal;
+	Board keptSol;	// fullest board found in this solve: bestSol can be replaced
+	int keptVal;	// by a worse one in ACS, whose best value evaporates
+	int lastGrowth;	// iteration keptVal last grew
 	Timer solutionTimer;
 	float solTime;
 	int iter;
+	bool prune;	// abandon ants which cannot improve on the best
+	bool mostConstrainedFirst;	// ants fill the cell with fewest possibilities next
+
+	// MAX-MIN ant system variant
+	bool maxMin;
+	float mmRho;	// global evaporation rate
+	float tauMin, tauMax;	// pheromone bounds
+	int stagnationIters;	// restart after this many iterations without improvement
+	int restartIter;	// iteration of the last pheromone reset
+	int lastImprovement;	// iteration of the last best-so-far improvement
+	bool resetPheromone;	// set all pheromone to tauMax at the next update
+
+	// online adaptation of q0 and rho and bestEvap, or mmRho for MMAS
+	bool adaptive;
+	float baseQ0, baseRho, baseEvap, baseMmRho;	// values given on construction and to SetMaxMin
+	std::vector<int> sampleCells;	// open cells used to measure ant diversity
+
+	// bounded exact completion of the best solution
+	int completeCells;	// try when the best is at most this many cells short, 0 for never
+	int completeNodes;	// backtracking step limit for each attempt
+	bool completeUnfix;	// also release low-pheromone cells next to the empty ones
+
+	int saReplicas;	// number of parallel tempering replicas for the annealer, 1 for a single chain
+	bool saDomains;	// annealer only swaps values within the puzzle's propagated candidates
+	int saStall;	// start a background anneal after this many iterations without a new best
+
+	// per-ant local improvement before the iteration best is chosen
+	int antLocalTries;	// repair trials per ant and iteration, 0 for none
+	Timer localSearchTimer;
+	float localSearchTime;	// total time spent in it during the last solve
+	int localSearchRepairs;	// total cells it filled during the last solve
 
 	std::vector<SudokuAnt*> antList;
-	std::mt19937 randGen; 
-	std::uniform_real_distribution<float> randomDist;
+	RandomGenerator randGen;
+	UniformBuffer uniforms;	// for random(), drawn from randGen a block at a time
+	bool seeded;	// SetSeed called: keep runs repeatable
 
-	float **pher; // pheromone matrix
+	float **pher; // pheromone matrix, kept between solves
+	int pherValues;	// values per cell in the matrix
 	int numCells;
+	Board warmStart;	// solution to seed the pheromone with on the next solve
+	bool hasWarmStart;
 	void InitPheromone(int numCells, int valuesPerCell);
+	void SeedPheromone(const Board& puzzle);
 	void ClearPheromone();
 	void UpdatePheromone();
 	float PherAdd(int numCellsFixed);
+	bool CanImprove(int maxCellsFilled, int iterMinCellsFilled);
+	int PruneAnts();
+	void MaxMinUpdate(const Board& iterBestSol, int iterBestVal);
+	float PheromoneEntropy(int valuesPerCell);
+	void InitAdaptive(const Board& puzzle);
+	float AntDiversity();
+	void AdaptParameters();
+	bool CompleteBest(const Board& puzzle, float maxTime);
+	void KeepBest(const Board& board, int val);
 
 public:
 	SudokuAntSystem(int numAnts, float q0, float rho, float pher0, float bestEvap) : 
-		numAnts(numAnts), q0(q0), rho(rho), pher0(pher0), bestEvap(bestEvap)
+		numAnts(numAnts), q0(q0), rho(rho), pher0(pher0), bestEvap(bestEvap), prune(false), mostConstrainedFirst(false),
+		maxMin(false), mmRho(0.5f), stagnationIters(300),
+		adaptive(false), baseQ0(q0), baseRho(rho), baseEvap(bestEvap), baseMmRho(0.5f),
+		completeCells(0), completeNodes(2000), completeUnfix(false),
+		saReplicas(1),
+		saDomains(false),
+		saStall(100),
+		antLocalTries(0), localSearchTime(0.0f), localSearchRepairs(0),
+		seeded(false),
+		pher(nullptr), pherValues(0), numCells(0), hasWarmStart(false)
 	{
 		for ( int i = 0; i < numAnts; i++ )
 			antList.push_back(new SudokuAnt(this));
-		randomDist = std::uniform_real_distribution<float>(0.0f, 1.0f);
-		std::random_device rd;
-		randGen = std::mt19937(rd());
+		randGen.seed(RandomSeed());
 	}
 	~SudokuAntSystem()
 	{
+		ClearPheromone();
 		for (auto a : antList)
 			delete a;
 	}
@@ -50,9 +106,23 @@ public:
 	virtual float GetSolutionTime() { return solTime; }
 	virtual int GetCycles() { return iter; }
 	virtual const Board& GetSolution() { return bestSol; }
+	virtual void SetWarmStart(const Board &previous) { warmStart = previous; hasWarmStart = true; }
+	virtual void SetSeed(unsigned int seed) { randGen.seed(DeriveSeed(seed, 0)); uniforms.Reset(); seeded = true; }
+	void SetPruning(bool p) { prune = p; }
+	void SetMostConstrainedFirst(bool m) { mostConstrainedFirst = m; }
+	void SetMaxMin(float mmRho, int stagnationIters);
+	void SetAdaptive(bool a) { adaptive = a; }
+	void SetAnnealReplicas(int n) { saReplicas = n; }
+	void SetAnnealDomains(bool use) { saDomains = use; }
+	void SetAnnealStall(int iters) { saStall = iters < 1 ? 1 : iters; }
+	void SetAntLocalSearch(int tries) { antLocalTries = tries; }
+	float GetLocalSearchTime() { return localSearchTime; }
+	int GetLocalSearchRepairs() { return localSearchRepairs; }
+	void SetCompletion(int cells, int nodes, bool unfix) { completeCells = cells; completeNodes = nodes; completeUnfix = unfix; }
 	// helpers for ants
 	inline float Getq0() { return q0; }
-	inline float random() { return randomDist(randGen); }
+	inline bool MostConstrainedFirst() { return mostConstrainedFirst; }
+	inline float random() { return uniforms.Next(randGen); }
 	inline float Pher(int i, int j) { return pher[i][j]; }
 	void LocalPheromoneUpdate(int iCell, int iChoice);
 };
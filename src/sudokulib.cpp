@@ -0,0 +1,187 @@
+#include "sudokulib.h"
+#include "puzzleio.h"
+#include "selector.h"
+#include "puzzleeditor.h"
+#include "timer.h"
+#include <sstream>
+#include <vector>
+#include <cstring>
+using namespace std;
+
+SolverOptions ParseSolverOptions( const string &options )
+{
+	// split into words and hand them to Arguments as if from the command line
+	istringstream in(options);
+	vector<string> words(1);
+	string word;
+	while ( in >> word )
+		words.push_back(word);
+	vector<char *> argv;
+	for ( auto &w : words )
+		argv.push_back(&w[0]);
+	Arguments a((int)argv.size(), argv.data());
+	return ReadSolverOptions(a);
+}
+
+SudokuContext::SudokuContext( int numUnits, const SolverOptions &opt ) :
+	numUnits(numUnits), solver(nullptr), opt(opt), cache(nullptr), fromCache(false), timeOut(opt.timeOut), seed(0), seeded(false), solTime(0.0f), cycles(0)
+{
+	int units, boxRows, boxCols;
+	if ( !PuzzleGeometry(numUnits * numUnits, units, boxRows, boxCols) )
+		return;
+	Board blank(string(numUnits * numUnits, '.'));
+	if ( opt.algorithm == AUTO_ALGORITHM )
+	{
+		// start with the blank board's choice, others are made as puzzles need them
+		ruleSolvers.resize(NumSelectorRules(), nullptr);
+		int rule = SelectRule(ComputeFeatures(blank));
+		ruleSolvers[rule] = CreateSolver(RuleOptions(rule, opt), blank);
+		solver = ruleSolvers[rule];
+	}
+	else
+		solver = CreateSolver(opt, blank);
+}
+
+SudokuContext::~SudokuContext()
+{
+	if ( ruleSolvers.empty() )
+		delete solver;
+	for ( auto s : ruleSolvers )
+		delete s;
+}
+
+bool SudokuContext::Solve( const Board &puzzle )
+{
+	if ( solver == nullptr || puzzle.GetNumUnits() != numUnits )
+		return false;
+	fromCache = false;
+	CanonicalForm form;
+	if ( cache != nullptr )
+	{
+		Timer lookupTimer;
+		lookupTimer.Reset();
+		form = Canonicalise(puzzle);
+		if ( cache->Lookup(form, puzzle, cachedSolution) )
+		{
+			fromCache = true;
+			solTime = lookupTimer.Elapsed();
+			cycles = 0;
+			return true;
+		}
+	}
+	if ( !ruleSolvers.empty() )
+	{
+		int rule = SelectRule(ComputeFeatures(puzzle));
+		if ( ruleSolvers[rule] == nullptr )
+			ruleSolvers[rule] = CreateSolver(RuleOptions(rule, opt), puzzle);
+		solver = ruleSolvers[rule];
+	}
+	if ( seeded )
+		solver->SetSeed(seed);
+	bool success = solver->Solve(puzzle, timeOut);
+	if ( success && !puzzle.CheckSolution(solver->GetSolution()) )
+		success = false;
+	solTime = solver->GetSolutionTime();
+	cycles = solver->GetCycles();
+	if ( success && cache != nullptr )
+		cache->Insert(form, solver->GetSolution());
+	return success;
+}
+
+struct sudoku_context
+{
+	SudokuContext context;
+	SolutionCache *cache;
+	sudoku_context( int numUnits, const SolverOptions &opt ) : context(numUnits, opt), cache(CreateSolutionCache(opt))
+	{
+		context.SetCache(cache);
+	}
+	~sudoku_context() { delete cache; }
+};
+
+static void WriteSolution( const Board &result, int numUnits, char *solution )
+{
+	for ( int i = 0; i < numUnits * numUnits; i++ )
+	{
+		const ValueSet &cell = result.GetCell(i);
+		solution[i] = PuzzleValueChar(cell.Fixed() ? cell.Index() + 1 : 0, numUnits);
+	}
+}
+
+extern "C" sudoku_context *sudoku_create( int num_units, const char *options )
+{
+	sudoku_context *ctx = new sudoku_context(num_units, ParseSolverOptions(options != nullptr ? options : ""));
+	if ( !ctx->context.IsValid() )
+	{
+		delete ctx;
+		return nullptr;
+	}
+	return ctx;
+}
+
+extern "C" void sudoku_destroy( sudoku_context *ctx )
+{
+	delete ctx;
+}
+
+extern "C" int sudoku_solve( sudoku_context *ctx, const char *puzzle, int length, char *solution )
+{
+	int numUnits = ctx->context.GetNumUnits();
+	if ( puzzle == nullptr || length != numUnits * numUnits || !ValidPuzzleChars(puzzle, length, numUnits) )
+		return -1;
+	Board board(puzzle, length);
+	bool success = ctx->context.Solve(board);
+	if ( solution != nullptr )
+		WriteSolution(ctx->context.GetSolution(), numUnits, solution);
+	return success ? 1 : 0;
+}
+
+extern "C" float sudoku_solution_time( const sudoku_context *ctx )
+{
+	return ctx->context.GetSolutionTime();
+}
+
+extern "C" int sudoku_cycles( const sudoku_context *ctx )
+{
+	return ctx->context.GetCycles();
+}
+
+struct sudoku_editor
+{
+	PuzzleEditor editor;
+	sudoku_editor( int numUnits, const SolverOptions &opt ) : editor(numUnits, opt) {}
+};
+
+extern "C" sudoku_editor *sudoku_editor_create( int num_units, const char *options )
+{
+	sudoku_editor *ed = new sudoku_editor(num_units, ParseSolverOptions(options != nullptr ? options : ""));
+	if ( !ed->editor.IsValid() )
+	{
+		delete ed;
+		return nullptr;
+	}
+	return ed;
+}
+
+extern "C" void sudoku_editor_destroy( sudoku_editor *ed )
+{
+	delete ed;
+}
+
+extern "C" int sudoku_editor_set( sudoku_editor *ed, int cell, int value )
+{
+	if ( value == 0 )
+	{
+		ed->editor.RemoveClue(cell);
+		return 1;
+	}
+	return ed->editor.AddClue(cell, value) ? 1 : 0;
+}
+
+extern "C" int sudoku_editor_solve( sudoku_editor *ed, char *solution )
+{
+	bool success = ed->editor.Solve();
+	if ( success && solution != nullptr )
+		WriteSolution(ed->editor.GetSolution(), ed->editor.GetNumUnits(), solution);
+	return success ? 1 : 0;
+}
@@ -0,0 +1,92 @@
+#pragma once
+//
+// Embeddable solver API. A context is made once for one board geometry and
+// can then solve any number of puzzles of that size, keeping its solver and
+// working buffers between solves. Separate contexts share no state and can
+// be used from different threads at the same time; one context must only be
+// used by one thread at a time.
+//
+// Puzzles and solutions are in the --puzzle string format, with '.' for
+// blanks. Options are given as a command-line style string, e.g.
+// "--alg 2 --ants 20 --timeout 5", and take the same defaults.
+//
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sudoku_context sudoku_context;
+
+// context for boards of num_units x num_units cells, or NULL if the size is not supported
+sudoku_context *sudoku_create(int num_units, const char *options);
+void sudoku_destroy(sudoku_context *ctx);
+
+// solve a puzzle of num_units*num_units characters. Returns 1 if solved,
+// 0 if not, -1 if the puzzle does not fit the context (wrong length, or a
+// character that is not a blank or a value of this size). If solution is not
+// NULL it receives num_units*num_units characters (no terminator), with '.'
+// for cells left unset.
+int sudoku_solve(sudoku_context *ctx, const char *puzzle, int length, char *solution);
+
+// time taken by the last solve in seconds, and its cycle count (iterations
+// for the ant systems, moves per second for the local searches)
+float sudoku_solution_time(const sudoku_context *ctx);
+int sudoku_cycles(const sudoku_context *ctx);
+
+// A puzzle edited one clue at a time (see puzzleeditor.h), starting blank.
+// Cells are numbered row by row from 0. sudoku_editor_set gives a cell a
+// clue of 1..num_units, or removes its clue with 0, and returns 0 if the
+// value is ruled out by the other clues. sudoku_editor_solve re-solves from
+// the last solution and returns 1 if solved, when solution (if not NULL)
+// receives it as for sudoku_solve.
+typedef struct sudoku_editor sudoku_editor;
+sudoku_editor *sudoku_editor_create(int num_units, const char *options);
+void sudoku_editor_destroy(sudoku_editor *ed);
+int sudoku_editor_set(sudoku_editor *ed, int cell, int value);
+int sudoku_editor_solve(sudoku_editor *ed, char *solution);
+
+#ifdef __cplusplus
+}
+
+#include "solveroptions.h"
+#include "solutioncache.h"
+#include "board.h"
+#include <string>
+#include <vector>
+
+// C++ interface to the same contexts
+class SudokuContext
+{
+	int numUnits;
+	SudokuSolver *solver;
+	SolverOptions opt;
+	std::vector<SudokuSolver *> ruleSolvers;	// with --alg auto, one per selector rule, made when first used
+	SolutionCache *cache;	// not owned
+	Board cachedSolution;
+	bool fromCache;		// last solution came from the cache
+	float timeOut;
+	unsigned int seed;
+	bool seeded;		// SetSeed called, so each solve starts from seed
+	float solTime;
+	int cycles;
+	SudokuContext(const SudokuContext &);
+	SudokuContext &operator=(const SudokuContext &);
+public:
+	SudokuContext(int numUnits, const SolverOptions &opt);
+	~SudokuContext();
+	bool IsValid() const { return solver != nullptr; }
+	int GetNumUnits() const { return numUnits; }
+	bool Solve(const Board &puzzle);
+	const Board &GetSolution() { return fromCache ? cachedSolution : solver->GetSolution(); }
+	float GetSolutionTime() const { return solTime; }
+	int GetCycles() const { return cycles; }
+	void SetTimeOut(float secs) { timeOut = secs; }
+	// make the following solves repeatable: each starts its random numbers from s
+	void SetSeed(unsigned int s) { seed = s; seeded = true; }
+	// answer repeats (up to symmetry) from cache, and add new solutions to it
+	void SetCache(SolutionCache *c) { cache = c; }
+	bool FromCache() const { return fromCache; }
+};
+
+// options from a command-line style string
+SolverOptions ParseSolverOptions(const std::string &options);
+#endif
@@ -1,12 +1,48 @@
 #pragma once
 #include "board.h"
+#include <atomic>
+#include <vector>
+
+// a new best during a solve: when, and how good the best board then was
+struct Improvement
+{
+	float time;		// seconds since the solve started
+	int cellsFilled;
+	int conflicts;	// repeated values in rows, columns and boxes
+};
 
 // pure virtual interface shared between backtrack search and sudoku ant system
 class SudokuSolver
 {
 public:
+	SudokuSolver() : stopFlag(nullptr) {}
+	virtual ~SudokuSolver() {}
 	virtual bool Solve(const Board& puzzle, float maxTime) = 0;
 	virtual float GetSolutionTime() = 0;
 	virtual int GetCycles() = 0;
+	// the solution, or after a failed solve the best board found
 	virtual const Board& GetSolution() = 0;
+	// every new best of the last solve, in order
+	const std::vector<Improvement> &GetTrace() const { return trace; }
+
+	// shared stop token: once *flag is set, Solve returns as soon as it
+	// next checks, which each solver does in its inner loop
+	void SetStopFlag(const std::atomic<bool> *flag) { stopFlag = flag; }
+
+	// solution of a closely related puzzle (e.g. before a clue was edited),
+	// which the next Solve may start from. Solvers without a use for it
+	// ignore it.
+	virtual void SetWarmStart(const Board &previous) {}
+	// seed for the solver's random numbers, so that a run can be repeated
+	// (as far as its threads allow). Deterministic solvers ignore it.
+	virtual void SetSeed(unsigned int seed) {}
+protected:
+	const std::atomic<bool> *stopFlag;
+	std::vector<Improvement> trace;
+	void RecordImprovement(float time, int cellsFilled, int conflicts)
+	{
+		Improvement step = { time, cellsFilled, conflicts };
+		trace.push_back(step);
+	}
+	bool StopRequested() const { return stopFlag != nullptr && stopFlag->load(std::memory_order_relaxed); }
 };
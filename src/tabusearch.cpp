@@ -0,0 +1,166 @@
+#include "tabusearch.h"
+#include <algorithm>
+
+TabuSearch::TabuSearch(int tenure, int restartMoves, int historyLength) :
+    solTime(0.0f), movesPerSec(0.0f), tenure(tenure), restartMoves(restartMoves),
+    historyLength(historyLength), useDomains(false), numUnits(0), hash(0)
+{
+    gen.seed(RandomSeed());
+}
+
+bool TabuSearch::Solve(const Board& puzzle, float maxTime)
+{
+    solutionTimer.Reset();
+    sol.Copy(puzzle);
+    grid.Init(sol, useDomains ? &puzzle : nullptr);
+    numUnits = grid.NumUnits();
+
+    int numCells = grid.CellCount();
+    // a step scans every conflicted cell's box, so it gets slower with
+    // the board size; check the clock every 64 steps on 9x9 and every
+    // step by 64x64, where one step can take milliseconds
+    const int timerCheckInterval = std::max(1, 64*81/numCells);
+    zobrist.resize(numCells*numUnits);
+    for (auto &z : zobrist)
+        z = ((uint64_t)gen() << 32) ^ gen();
+    tabuUntil.assign(numCells*numUnits, 0);
+
+    grid.Fill(gen);
+    Restart();
+    int runBest = grid.Cost();
+    int bestCost = runBest;
+    std::vector<int> bestValues;    // best grid so far, returned if time runs out
+    grid.Save(bestValues);
+    trace.clear();
+    RecordImprovement(solutionTimer.Elapsed(), numCells, bestCost);
+    long long move = 0, step = 0;
+    long long lastImprovement = 0;
+    while (grid.Cost() > 0)
+    {
+        if (StopRequested() || ((step++ % timerCheckInterval) == 0 && solutionTimer.Elapsed() > maxTime))
+            break;
+
+        int idx1, idx2;
+        bool stalled = restartMoves > 0 && move - lastImprovement >= restartMoves;
+        if (stalled || !BestMove(move, runBest, idx1, idx2))
+        {
+            // start again from a random fill, also when no swap is possible
+            grid.Refill(gen);
+            Restart();
+            runBest = grid.Cost();
+            lastImprovement = move;
+            continue;
+        }
+        int v1 = grid.Value(idx1), v2 = grid.Value(idx2);
+        hash = SwapHash(idx1, idx2);
+        grid.Swap(idx1, idx2);
+        Remember(hash);
+        ++move;
+        tabuUntil[idx1*numUnits + v1] = move + tenure;
+        tabuUntil[idx2*numUnits + v2] = move + tenure;
+
+        if (grid.Cost() < runBest)
+        {
+            runBest = grid.Cost();
+            lastImprovement = move;
+            if (runBest < bestCost)
+            {
+                bestCost = runBest;
+                grid.Save(bestValues);
+                RecordImprovement(solutionTimer.Elapsed(), numCells, bestCost);
+            }
+        }
+    }
+
+    if (grid.Cost() > bestCost)
+        grid.Restore(bestValues);
+    grid.WriteTo(sol);
+    solTime = solutionTimer.Elapsed();
+    movesPerSec = solTime > 0.0f ? (float)(move / solTime) : 0.0f;
+    return grid.Cost() == 0;
+}
+
+void TabuSearch::Restart()
+{
+    // the hash and history describe the current fill only
+    hash = 0;
+    for (int i = 0; i < grid.CellCount(); i++)
+        hash ^= zobrist[i*numUnits + grid.Value(i)];
+    recent.clear();
+    recentOrder.clear();
+    Remember(hash);
+}
+
+uint64_t TabuSearch::SwapHash(int idx1, int idx2) const
+{
+    // hash of the grid after swapping the values of two cells
+    int v1 = grid.Value(idx1), v2 = grid.Value(idx2);
+    return hash ^ zobrist[idx1*numUnits + v1] ^ zobrist[idx1*numUnits + v2]
+                ^ zobrist[idx2*numUnits + v2] ^ zobrist[idx2*numUnits + v1];
+}
+
+void TabuSearch::Remember(uint64_t h)
+{
+    if (!recent.insert(h).second)
+        return;
+    recentOrder.push_back(h);
+    if ((int)recentOrder.size() > historyLength)
+    {
+        recent.erase(recentOrder.front());
+        recentOrder.pop_front();
+    }
+}
+
+bool TabuSearch::BestMove(long long move, int bestCost, int &idx1, int &idx2)
+{
+    // best admissible swap of a conflicted cell with a partner in its box,
+    // ties broken at random. A tabu or recently visited move is admissible
+    // if it gives a new best. If every move is forbidden, take any move.
+    int cost = grid.Cost();
+    int bestDelta = 0, numBest = 0;
+    int anyCount = 0;
+    for (int k = 0; k < grid.NumConflicted(); k++)
+    {
+        int a = grid.Conflicted(k);
+        int va = grid.Value(a);
+        int box = grid.BoxForCell(a);
+        for (int j = 0; j < grid.NumBoxMovable(box); j++)
+        {
+            int b = grid.BoxMovable(box, j);
+            if (b == a || grid.Value(b) == va || (grid.HasDomains() && !grid.CanSwap(a, b)))
+                continue;
+
+            // keep one random move to fall back on
+            if (numBest == 0 && std::uniform_int_distribution<>(0, anyCount)(gen) == 0)
+            {
+                idx1 = a;
+                idx2 = b;
+            }
+            ++anyCount;
+
+            int delta = grid.SwapDelta(a, b);
+            if (numBest > 0 && delta > bestDelta)
+                continue;
+            int vb = grid.Value(b);
+            bool aspiration = cost + delta < bestCost;
+            if (!aspiration)
+            {
+                if (tabuUntil[a*numUnits + vb] > move || tabuUntil[b*numUnits + va] > move)
+                    continue;
+                if (recent.count(SwapHash(a, b)))
+                    continue;
+            }
+            if (numBest == 0 || delta < bestDelta)
+            {
+                bestDelta = delta;
+                numBest = 0;
+            }
+            if (std::uniform_int_distribution<>(0, numBest++)(gen) == 0)
+            {
+                idx1 = a;
+                idx2 = b;
+            }
+        }
+    }
+    return anyCount > 0;
+}
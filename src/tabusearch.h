@@ -0,0 +1,53 @@
+#pragma once
+#include "board.h"
+#include "sagrid.h"
+#include "sudokusolver.h"
+#include "timer.h"
+#include "random.h"
+#include <vector>
+#include <deque>
+#include <unordered_set>
+#include <cstdint>
+
+//
+// Tabu search over the same box-permutation encoding as the annealer. Each
+// move is the best swap of a conflicted cell with a partner in its box, using
+// SAGrid's incremental cost tables. A cell may not take back a value it gave
+// up for a number of moves, and moves back to a recently visited state
+// (recognised by a Zobrist hash) are skipped, unless either would give a new
+// best. After too long without a new best the grid is refilled at random.
+//
+class TabuSearch : public SudokuSolver
+{
+    Board sol;
+    SAGrid grid;
+    RandomGenerator gen;
+    Timer solutionTimer;
+    float solTime;
+    float movesPerSec;
+    int tenure;             // moves for which a cell may not take back a value it gave up
+    int restartMoves;       // refill after this many moves without a new best, 0 for never
+    int historyLength;      // number of recent states remembered
+    bool useDomains;        // only swap values within the puzzle's propagated candidates
+
+    int numUnits;
+    std::vector<long long> tabuUntil;   // [cell*numUnits + value], move until which the cell may not take the value
+    std::vector<uint64_t> zobrist;      // [cell*numUnits + value]
+    uint64_t hash;                      // of the current grid
+    std::unordered_set<uint64_t> recent;
+    std::deque<uint64_t> recentOrder;
+
+public:
+    TabuSearch(int tenure = 10, int restartMoves = 5000, int historyLength = 1000);
+    void SetUseDomains(bool use) { useDomains = use; }
+    virtual bool Solve(const Board& puzzle, float maxTime);
+    virtual float GetSolutionTime() { return solTime; }
+    virtual int GetCycles() { return (int)movesPerSec; }
+    virtual const Board& GetSolution() { return sol; }
+    virtual void SetSeed(unsigned int seed) { gen.seed(DeriveSeed(seed, 0)); }
+private:
+    void Restart();
+    bool BestMove(long long move, int bestCost, int &idx1, int &idx2);
+    uint64_t SwapHash(int idx1, int idx2) const;
+    void Remember(uint64_t h);
+};
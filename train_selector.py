@@ -0,0 +1,241 @@
+import csv
+import math
+import os
+import re
+import sys
+from collections import defaultdict
+
+# Builds the table behind --alg auto (src/selectortable.h) from benchmark
+# result CSVs. Each CSV is tagged with the solver options it was run with.
+# The files come from different harnesses and run counts, so a raw
+# difference of a few microseconds says nothing: for every board size and
+# clue percentage the solver's defaults are kept unless other options do
+# significantly better, with a higher success rate (two-proportion z-test)
+# or as high a rate and a lower mean time (Welch's t-test on the summary
+# columns, as sudokubench --compare does) by at least MIN_SPEEDUP and
+# MIN_SAVING. Choices are tried nearest the defaults first (ACS settings
+# before other algorithms), and each replaces the current one only if
+# significantly better than it, so options that cannot be told apart do
+# not flip on noise. Neighbouring clue percentages with the same choice are
+# merged into one rule.
+#
+# Two CSV layouts are read:
+#   summary rows from run_solver.py: Type,Clue %,...,Success Rate (%),Avg Time,...
+#   per-run rows from --batch:       instance,run,success,time,cycles
+#
+# Usage: python3 train_selector.py [file.csv="--alg 4 --tenure 10" ...]
+# Files given on the command line are added to (or replace) the ones below.
+
+# options each of our result files was produced with. The t0 and cooling
+# ablations varied the annealer inside ACS, which has no option of its own,
+# so they are left out, as is acs.csv, whose options were not recorded.
+# backtrack.csv, annealing.csv and tabu.csv are --batch runs of instances
+# 0-4 of each size and clue % with --timeout 5, shorter than the ACS runs
+# were given, so on the hardest puzzles they can only lose to ACS.
+CONFIGS = {
+    "sudoku_results.csv": "--alg 0",
+    "backtrack.csv": "--alg 1",
+    "annealing.csv": "--alg 3",
+    "tabu.csv": "--alg 4",
+    "ablation-nants_5.csv": "--alg 0 --ants 5",
+    "ablation-nants_15.csv": "--alg 0 --ants 15",
+    "ablation_raw/ablation-safreq_50.csv": "--alg 0 --sastall 50",
+    "ablation_raw/ablation-safreq_100.csv": "--alg 0 --sastall 100",
+    "ablation_raw/ablation-safreq_150.csv": "--alg 0 --sastall 150",
+    "ablation_raw/ablation-safreq_200.csv": "--alg 0 --sastall 200",
+    "ablation_raw/ablation-safreq_300.csv": "--alg 0 --sastall 300",
+    "ablation_raw/ablation-safreq_500.csv": "--alg 0 --sastall 500",
+}
+
+OUTPUT_FILE = "src/selectortable.h"
+
+# the options a rule can set, with the solver's defaults
+DEFAULTS = {"alg": 0, "ants": 10, "sastall": 100}
+
+# significance level, and the smallest time saving worth a switch: relative,
+# and in seconds, below which the harnesses' own overheads dominate
+ALPHA = 0.05
+MIN_SPEEDUP = 0.1
+MIN_SAVING = 2.5e-4
+
+
+def parse_options(options):
+    """Returns (alg, ants, sastall) for an option string."""
+    values = dict(DEFAULTS)
+    words = options.split()
+    for i, w in enumerate(words):
+        name = w.lstrip("-")
+        if w.startswith("--") and name in values and i + 1 < len(words):
+            values[name] = int(words[i + 1])
+    return values["alg"], values["ants"], values["sastall"]
+
+
+def beta_fraction(a, b, x):
+    """Continued fraction for the incomplete beta function (Lentz)."""
+    tiny = 1e-300
+    c = 1.0
+    d = 1.0 - (a + b) * x / (a + 1.0)
+    d = 1.0 / tiny if abs(d) < tiny else 1.0 / d
+    h = d
+    for m in range(1, 301):
+        m2 = 2.0 * m
+        for aa in (m * (b - m) * x / ((a + m2 - 1.0) * (a + m2)),
+                   -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0))):
+            d = 1.0 + aa * d
+            d = 1.0 / tiny if abs(d) < tiny else 1.0 / d
+            c = 1.0 + aa / c
+            if abs(c) < tiny:
+                c = tiny
+            step = d * c
+            h *= step
+        if abs(step - 1.0) < 1e-12:
+            break
+    return h
+
+
+def incomplete_beta(a, b, x):
+    """Regularised incomplete beta function I_x(a, b)."""
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    front = math.exp(math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b) + a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return front * beta_fraction(a, b, x) / a
+    return 1.0 - front * beta_fraction(b, a, 1.0 - x) / b
+
+
+def welch_test(m1, sd1, n1, m2, sd2, n2):
+    """Two-sided p-value of Welch's t-test from means, deviations and sizes."""
+    if n1 < 2 or n2 < 2:
+        return 1.0
+    v1 = sd1 * sd1 / n1
+    v2 = sd2 * sd2 / n2
+    if v1 + v2 == 0.0:
+        return 1.0 if m1 == m2 else 0.0
+    t = (m2 - m1) / math.sqrt(v1 + v2)
+    df = (v1 + v2) ** 2 / (v1 * v1 / (n1 - 1) + v2 * v2 / (n2 - 1))
+    return incomplete_beta(df / 2.0, 0.5, df / (df + t * t))
+
+
+def proportion_test(s1, n1, s2, n2):
+    """Two-sided p-value of a difference in success rates."""
+    if n1 == 0 or n2 == 0:
+        return 1.0
+    pooled = (s1 + s2) / (n1 + n2)
+    se = math.sqrt(pooled * (1.0 - pooled) * (1.0 / n1 + 1.0 / n2))
+    if se == 0.0:
+        return 1.0
+    z = (s2 / n2 - s1 / n1) / se
+    return math.erfc(abs(z) / math.sqrt(2.0))
+
+
+def better(cand, base):
+    """True if result cand is significantly better than base."""
+    n1, s1, m1, sd1 = base
+    n2, s2, m2, sd2 = cand
+    if proportion_test(s1, n1, s2, n2) < ALPHA:
+        return s2 / n2 > s1 / n1
+    return (s2 / n2 >= s1 / n1 and m2 < (1.0 - MIN_SPEEDUP) * m1 and m1 - m2 > MIN_SAVING and
+            welch_test(m1, sd1, s1, m2, sd2, s2) < ALPHA)
+
+
+def order(entry, default_rule):
+    """Sort key: other algorithms after ACS settings, then fewer changed
+    options, then best rate and time first."""
+    (n, s, m, sd), rule = entry
+    changed = sum(a != b for a, b in zip(rule, default_rule))
+    return (rule[0] != default_rule[0], changed, -s / n, m)
+
+
+def read_results(file_name):
+    """Returns {(numUnits, cluePercent): (runs, successes, avgTime, sdTime)},
+    with the times taken over the successful runs."""
+    results = {}
+    with open(file_name, newline="") as f:
+        rows = list(csv.DictReader(f))
+    if rows and "instance" in rows[0]:
+        # per-run records, grouped by the size and clue % in the instance name
+        runs = defaultdict(list)
+        for r in rows:
+            m = re.search(r"inst(\d+)x\d+_(\d+)_", r["instance"])
+            if m:
+                runs[(int(m.group(1)), int(m.group(2)))].append(r)
+        for key, group in runs.items():
+            solved = [float(r["time"]) for r in group if r["success"] == "1"]
+            avg = sum(solved) / len(solved) if solved else float("inf")
+            sd = 0.0
+            if len(solved) > 1:
+                sd = math.sqrt(sum((t - avg) ** 2 for t in solved) / (len(solved) - 1))
+            results[key] = (len(group), len(solved), avg, sd)
+    else:
+        for r in rows:
+            if "Avg Time" not in r:
+                continue
+            units = int(r["Type"].split("x")[0])
+            total = int(r["Total Instances"])
+            successes = int(r["Successes"])
+            avg = float(r["Avg Time"]) if successes else float("inf")
+            results[(units, int(r["Clue %"]))] = (total, successes, avg, float(r["Std Dev Time"]))
+    return results
+
+
+def main():
+    configs = dict(CONFIGS)
+    for arg in sys.argv[1:]:
+        name, _, options = arg.partition("=")
+        configs[name] = options
+
+    # every result per size and clue %, as (result, rule)
+    results = defaultdict(list)
+    for file_name, options in configs.items():
+        if not os.path.exists(file_name):
+            print(f"skipping {file_name} (not found)")
+            continue
+        print(f"Reading {file_name} ({options})")
+        rule = parse_options(options)
+        for key, result in read_results(file_name).items():
+            if result[0] > 0:
+                results[key].append((result, rule))
+
+    # start from the defaults (or the best, where they were not run) and
+    # switch only to a significantly better choice
+    default_rule = parse_options("")
+    best = {}
+    for key, entries in results.items():
+        entries.sort(key=lambda e: order(e, default_rule))
+        choice = next((e for e in entries if e[1] == default_rule), entries[0])
+        for e in entries:
+            if e is not choice and better(e[0], choice[0]):
+                choice = e
+        best[key] = choice[1]
+
+    # merge neighbouring clue percentages with the same choice
+    rules = []
+    for units in sorted(set(k[0] for k in best)):
+        pcts = sorted(k[1] for k in best if k[0] == units)
+        for i, pct in enumerate(pcts):
+            rule = best[(units, pct)]
+            last = i + 1 == len(pcts)
+            if last or best[(units, pcts[i + 1])] != rule:
+                rules.append((units, 100 if last else pct) + rule)
+
+    with open(OUTPUT_FILE, "w") as f:
+        f.write("#pragma once\n")
+        f.write("// generated by train_selector.py from:\n")
+        for file_name in sorted(configs):
+            if os.path.exists(file_name):
+                f.write(f"//   {file_name}\n")
+        f.write("// rerun it rather than editing this file by hand\n")
+        f.write("\n")
+        f.write("// numUnits, maxCluePercent, algorithm, nAnts, saStall\n")
+        f.write("static const SelectorRule selectorTable[] =\n{\n")
+        for r in rules:
+            f.write("\t{ %d, %d, %d, %d, %d },\n" % r)
+        f.write("};\n")
+
+    print(f"\nDONE! {len(rules)} rules saved to {OUTPUT_FILE}")
+
+
+if __name__ == "__main__":
+    main()